@@ -139,6 +139,68 @@ block_write (struct block *block, block_sector_t sector, const void *buffer)
   block->write_cnt++;
 }
 
+/* Verifies that the CNT sectors starting at SECTOR are all
+   valid offsets within BLOCK.  Panics if not. */
+static void
+check_sectors (struct block *block, block_sector_t sector,
+               block_sector_t cnt)
+{
+  ASSERT (cnt > 0);
+  check_sector (block, sector);
+  if (cnt > block->size - sector)
+    PANIC ("Access past end of device %s (sector=%"PRDSNu", cnt=%"PRDSNu", "
+           "size=%"PRDSNu")\n", block_name (block), sector, cnt, block->size);
+}
+
+/* Reads CNT consecutive sectors starting at SECTOR from BLOCK.
+   Sector SECTOR + I is read into BUFFERS[I], which must have
+   room for BLOCK_SECTOR_SIZE bytes.  Devices that support it
+   transfer all of the sectors in a single request.
+   Internally synchronizes accesses to block devices, so external
+   per-block device locking is unneeded. */
+void
+block_read_multiple (struct block *block, block_sector_t sector,
+                     void *const buffers[], block_sector_t cnt)
+{
+  check_sectors (block, sector, cnt);
+  if (block->ops->read_multiple != NULL)
+    block->ops->read_multiple (block->aux, sector, buffers, cnt);
+  else
+    {
+      block_sector_t i;
+
+      for (i = 0; i < cnt; i++)
+        block->ops->read (block->aux, sector + i, buffers[i]);
+    }
+  block->read_cnt += cnt;
+}
+
+/* Writes CNT consecutive sectors starting at SECTOR to BLOCK.
+   Sector SECTOR + I is written from BUFFERS[I], which must
+   contain BLOCK_SECTOR_SIZE bytes.  Returns after the block
+   device has acknowledged receiving all of the data.  Devices
+   that support it transfer all of the sectors in a single
+   request.
+   Internally synchronizes accesses to block devices, so external
+   per-block device locking is unneeded. */
+void
+block_write_multiple (struct block *block, block_sector_t sector,
+                      const void *const buffers[], block_sector_t cnt)
+{
+  check_sectors (block, sector, cnt);
+  ASSERT (block->type != BLOCK_FOREIGN);
+  if (block->ops->write_multiple != NULL)
+    block->ops->write_multiple (block->aux, sector, buffers, cnt);
+  else
+    {
+      block_sector_t i;
+
+      for (i = 0; i < cnt; i++)
+        block->ops->write (block->aux, sector + i, buffers[i]);
+    }
+  block->write_cnt += cnt;
+}
+
 /* Returns the number of sectors in BLOCK. */
 block_sector_t
 block_size (struct block *block)
@@ -53,6 +53,10 @@ struct block *block_next (struct block *);
 block_sector_t block_size (struct block *);
 void block_read (struct block *, block_sector_t, void *);
 void block_write (struct block *, block_sector_t, const void *);
+void block_read_multiple (struct block *, block_sector_t, void *const[],
+                          block_sector_t cnt);
+void block_write_multiple (struct block *, block_sector_t,
+                           const void *const[], block_sector_t cnt);
 const char *block_name (struct block *);
 enum block_type block_type (struct block *);
 
@@ -65,6 +69,14 @@ struct block_operations
   {
     void (*read) (void *aux, block_sector_t, void *buffer);
     void (*write) (void *aux, block_sector_t, const void *buffer);
+
+    /* Optional.  Transfer CNT consecutive sectors in a single
+       request, one buffer per sector.  Drivers that leave these
+       null get one read or write call per sector instead. */
+    void (*read_multiple) (void *aux, block_sector_t,
+                           void *const buffers[], block_sector_t cnt);
+    void (*write_multiple) (void *aux, block_sector_t,
+                            const void *const buffers[], block_sector_t cnt);
   };
 
 struct block *block_register (const char *name, enum block_type,
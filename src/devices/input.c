@@ -2,15 +2,20 @@
 #include <debug.h>
 #include "devices/intq.h"
 #include "devices/serial.h"
+#include "threads/synch.h"
 
 /* Stores keys from the keyboard and serial port. */
 static struct intq buffer;
 
+/* Woken when a key arrives. */
+static struct wait_queue pollers;
+
 /* Initializes the input buffer. */
 void
 input_init (void) 
 {
   intq_init (&buffer);
+  wait_queue_init (&pollers);
 }
 
 /* Adds a key to the input buffer.
@@ -23,6 +28,7 @@ input_putc (uint8_t key)
 
   intq_putc (&buffer, key);
   serial_notify ();
+  wait_queue_wake (&pollers);
 }
 
 /* Retrieves a key from the input buffer.
@@ -50,3 +56,21 @@ input_full (void)
   ASSERT (intr_get_level () == INTR_OFF);
   return intq_full (&buffer);
 }
+
+/* Returns true if the input buffer is empty,
+   false otherwise.
+   Interrupts must be off. */
+bool
+input_empty (void)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  return intq_empty (&buffer);
+}
+
+/* Returns the wait queue that is woken whenever a key is added
+   to the input buffer. */
+struct wait_queue *
+input_wait_queue (void)
+{
+  return &pollers;
+}
@@ -8,5 +8,7 @@ void input_init (void);
 void input_putc (uint8_t);
 uint8_t input_getc (void);
 bool input_full (void);
+bool input_empty (void);
+struct wait_queue *input_wait_queue (void);
 
 #endif /* devices/input.h */
@@ -24,7 +24,11 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Alarms that have not gone off yet, soonest first. */
+static struct list alarms;
+
 static intr_handler_func timer_interrupt;
+static list_less_func alarm_less;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
@@ -36,6 +40,7 @@ void
 timer_init (void) 
 {
   pit_configure_channel (0, 2, TIMER_FREQ);
+  list_init (&alarms);
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
@@ -96,6 +101,43 @@ timer_sleep (int64_t ticks)
     thread_yield ();
 }
 
+/* Sets ALARM to go off in TICKS timer ticks, at which point it
+   ups SEMA and sets its `expired' member.  The caller must
+   cancel ALARM with timer_alarm_cancel() before ALARM goes out
+   of scope, whether or not it has gone off. */
+void
+timer_alarm_set (struct timer_alarm *alarm, int64_t ticks,
+                 struct semaphore *sema)
+{
+  enum intr_level old_level;
+
+  ASSERT (alarm != NULL && sema != NULL);
+
+  old_level = intr_disable ();
+  alarm->wake_tick = timer_ticks () + ticks;
+  alarm->sema = sema;
+  alarm->expired = false;
+  list_insert_ordered (&alarms, &alarm->elem, alarm_less, NULL);
+  intr_set_level (old_level);
+}
+
+/* Cancels ALARM, if it has not gone off yet. */
+void
+timer_alarm_cancel (struct timer_alarm *alarm)
+{
+  enum intr_level old_level;
+
+  ASSERT (alarm != NULL);
+
+  old_level = intr_disable ();
+  if (!alarm->expired)
+    {
+      list_remove (&alarm->elem);
+      alarm->expired = true;
+    }
+  intr_set_level (old_level);
+}
+
 /* Sleeps for approximately MS milliseconds.  Interrupts must be
    turned on. */
 void
@@ -171,9 +213,30 @@ static void
 timer_interrupt (struct intr_frame *args UNUSED)
 {
   ticks++;
+  while (!list_empty (&alarms))
+    {
+      struct timer_alarm *alarm = list_entry (list_front (&alarms),
+                                              struct timer_alarm, elem);
+      if (alarm->wake_tick > ticks)
+        break;
+      list_pop_front (&alarms);
+      alarm->expired = true;
+      sema_up (alarm->sema);
+    }
   thread_tick ();
 }
 
+/* Returns true if alarm A_ goes off before alarm B_. */
+static bool
+alarm_less (const struct list_elem *a_, const struct list_elem *b_,
+            void *aux UNUSED)
+{
+  const struct timer_alarm *a = list_entry (a_, struct timer_alarm, elem);
+  const struct timer_alarm *b = list_entry (b_, struct timer_alarm, elem);
+
+  return a->wake_tick < b->wake_tick;
+}
+
 /* Returns true if LOOPS iterations waits for more than one timer
    tick, otherwise false. */
 static bool
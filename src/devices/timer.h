@@ -1,7 +1,9 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -19,6 +21,19 @@ void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
 
+/* An alarm that ups a semaphore when it goes off. */
+struct timer_alarm
+  {
+    int64_t wake_tick;          /* Tick to go off at. */
+    struct semaphore *sema;     /* Semaphore to up. */
+    bool expired;               /* Has it gone off? */
+    struct list_elem elem;      /* Element in alarm list. */
+  };
+
+void timer_alarm_set (struct timer_alarm *, int64_t ticks,
+                      struct semaphore *);
+void timer_alarm_cancel (struct timer_alarm *);
+
 /* Busy waits. */
 void timer_mdelay (int64_t milliseconds);
 void timer_udelay (int64_t microseconds);
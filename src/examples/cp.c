@@ -9,6 +9,7 @@ int
 main (int argc, char *argv[]) 
 {
   int in_fd, out_fd;
+  int size;
 
   if (argc != 3) 
     {
@@ -23,9 +24,10 @@ main (int argc, char *argv[])
       printf ("%s: open failed\n", argv[1]);
       return EXIT_FAILURE;
     }
+  size = filesize (in_fd);
 
   /* Create and open output file. */
-  if (!create (argv[2], filesize (in_fd))) 
+  if (!create (argv[2], size)) 
     {
       printf ("%s: create failed\n", argv[2]);
       return EXIT_FAILURE;
@@ -37,18 +39,11 @@ main (int argc, char *argv[])
       return EXIT_FAILURE;
     }
 
-  /* Copy data. */
-  for (;;) 
+  /* Copy data, inside the kernel. */
+  if (copy_file_range (in_fd, 0, out_fd, 0, size) != size)
     {
-      char buffer[1024];
-      int bytes_read = read (in_fd, buffer, sizeof buffer);
-      if (bytes_read == 0)
-        break;
-      if (write (out_fd, buffer, bytes_read) != bytes_read) 
-        {
-          printf ("%s: write failed\n", argv[2]);
-          return EXIT_FAILURE;
-        }
+      printf ("%s: write failed\n", argv[2]);
+      return EXIT_FAILURE;
     }
 
   return EXIT_SUCCESS;
@@ -0,0 +1,112 @@
+/* ipcbench.c
+
+   Measures synchronous IPC round-trip latency by bouncing a
+   message between a client process and a forked server process,
+   and compares it to the cost of a null system call.
+
+   Usage: ipcbench [ROUNDS]
+   makes ROUNDS round trips (default 10000) and reports the CPU
+   cycles taken by each, as counted by the time-stamp counter. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+/* Message word 0 values. */
+#define OP_PING 0               /* Reply with word 1 plus 1. */
+#define OP_QUIT 1               /* Exit without replying. */
+
+/* Returns the time-stamp counter. */
+static uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Serves pings until told to quit. */
+static void NO_RETURN
+serve (void)
+{
+  struct ipc_msg msg;
+  pid_t client = ipc_reply_wait (PID_ERROR, &msg);
+
+  while (client != PID_ERROR && msg.w[0] == OP_PING)
+    {
+      msg.w[1]++;
+      client = ipc_reply_wait (client, &msg);
+    }
+  exit (client != PID_ERROR ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/* Returns the average number of cycles taken by a system call
+   that does nothing, over ROUNDS calls. */
+static uint64_t
+null_syscall_cycles (unsigned rounds)
+{
+  uint64_t start = rdtsc ();
+  unsigned i;
+
+  for (i = 0; i < rounds; i++)
+    tell (-1);
+  return (rdtsc () - start) / rounds;
+}
+
+int
+main (int argc, char *argv[])
+{
+  unsigned rounds = argc > 1 ? atoi (argv[1]) : 10000;
+  uint64_t start, ipc_cycles, null_cycles;
+  struct ipc_msg msg;
+  pid_t server;
+  unsigned i;
+
+  if (rounds == 0)
+    {
+      printf ("usage: ipcbench [ROUNDS]\n");
+      return EXIT_FAILURE;
+    }
+
+  server = fork ();
+  if (server == PID_ERROR)
+    {
+      printf ("ipcbench: fork failed\n");
+      return EXIT_FAILURE;
+    }
+  if (server == 0)
+    serve ();
+
+  /* The first call waits for the server to get going. */
+  msg.w[0] = OP_PING;
+  msg.w[1] = 0;
+  if (ipc_call (server, &msg) < 0 || msg.w[1] != 1)
+    {
+      printf ("ipcbench: first call failed\n");
+      return EXIT_FAILURE;
+    }
+
+  start = rdtsc ();
+  for (i = 0; i < rounds; i++)
+    {
+      msg.w[0] = OP_PING;
+      msg.w[1] = i;
+      if (ipc_call (server, &msg) < 0 || msg.w[1] != i + 1)
+        {
+          printf ("ipcbench: call %u failed\n", i);
+          return EXIT_FAILURE;
+        }
+    }
+  ipc_cycles = (rdtsc () - start) / rounds;
+
+  msg.w[0] = OP_QUIT;
+  ipc_call (server, &msg);
+  wait (server);
+
+  null_cycles = null_syscall_cycles (rounds);
+  printf ("ipcbench: %u round trips, %llu cycles each; "
+          "null system call %llu cycles\n",
+          rounds, ipc_cycles, null_cycles);
+  return EXIT_SUCCESS;
+}
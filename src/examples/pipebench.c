@@ -0,0 +1,113 @@
+/* pipebench.c
+
+   Measures pipe throughput by streaming bytes from a parent
+   process to a child through a pipe.
+
+   Usage: pipebench [KB [BLOCK]]
+   streams KB kilobytes (default 4096) in writes of BLOCK bytes
+   (default 4096) and reports the CPU cycles taken per byte, as
+   counted by the time-stamp counter. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+/* Largest block size. */
+#define BLOCK_MAX 16384
+
+static char buf[BLOCK_MAX];
+
+/* Returns the time-stamp counter. */
+static uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Reads from FD until end of file, checking that byte N of the
+   stream is N % 251.  Returns true if all bytes were as
+   expected and there were TOTAL of them. */
+static bool
+drain (int fd, unsigned total)
+{
+  unsigned n = 0;
+  int cnt;
+
+  while ((cnt = read (fd, buf, sizeof buf)) > 0)
+    {
+      int i;
+
+      for (i = 0; i < cnt; i++, n++)
+        if ((uint8_t) buf[i] != n % 251)
+          return false;
+    }
+  return n == total;
+}
+
+int
+main (int argc, char *argv[])
+{
+  unsigned total = (argc > 1 ? atoi (argv[1]) : 4096) * 1024;
+  unsigned block = argc > 2 ? atoi (argv[2]) : 4096;
+  uint64_t start, cycles;
+  unsigned sent;
+  int fds[2];
+  pid_t pid;
+
+  if (block == 0 || block > BLOCK_MAX || total == 0)
+    {
+      printf ("usage: pipebench [KB [BLOCK]], with BLOCK <= %d\n",
+              BLOCK_MAX);
+      return EXIT_FAILURE;
+    }
+  if (!pipe (fds))
+    {
+      printf ("pipebench: pipe failed\n");
+      return EXIT_FAILURE;
+    }
+
+  pid = fork ();
+  if (pid == PID_ERROR)
+    {
+      printf ("pipebench: fork failed\n");
+      return EXIT_FAILURE;
+    }
+  if (pid == 0)
+    {
+      close (fds[1]);
+      return drain (fds[0], total) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  close (fds[0]);
+
+  start = rdtsc ();
+  for (sent = 0; sent < total; )
+    {
+      unsigned size = total - sent < block ? total - sent : block;
+      unsigned i;
+
+      for (i = 0; i < size; i++)
+        buf[i] = (sent + i) % 251;
+      if (write (fds[1], buf, size) != (int) size)
+        {
+          printf ("pipebench: write failed\n");
+          return EXIT_FAILURE;
+        }
+      sent += size;
+    }
+  close (fds[1]);
+  if (wait (pid) != EXIT_SUCCESS)
+    {
+      printf ("pipebench: reader saw bad data\n");
+      return EXIT_FAILURE;
+    }
+  cycles = rdtsc () - start;
+
+  printf ("pipebench: %u bytes in %u-byte writes, "
+          "%llu cycles, %llu.%02llu cycles/byte\n",
+          total, block, cycles, cycles / total,
+          cycles * 100 / total % 100);
+  return EXIT_SUCCESS;
+}
@@ -3,7 +3,11 @@
 #include <string.h>
 #include <syscall.h>
 
+/* Maximum number of commands in a pipeline. */
+#define MAX_STAGES 8
+
 static void read_line (char line[], size_t);
+static void run_pipeline (char *command);
 static bool backspace (char **pos, char line[]);
 
 int
@@ -30,6 +34,8 @@ main (void)
         {
           /* Empty command. */
         }
+      else if (strchr (command, '|') != NULL)
+        run_pipeline (command);
       else
         {
           pid_t pid = exec (command);
@@ -44,6 +50,80 @@ main (void)
   return EXIT_SUCCESS;
 }
 
+/* Runs each of the commands separated by `|' in COMMAND, with
+   the standard output of each one connected to the standard
+   input of the next through a pipe, and waits for all of them
+   to exit. */
+static void
+run_pipeline (char *command)
+{
+  char *stages[MAX_STAGES];
+  pid_t pids[MAX_STAGES];
+  int stage_cnt = 0;
+  int saved_in, saved_out;
+  int in_fd = -1;
+  char *stage, *save_ptr;
+  int i;
+
+  for (stage = strtok_r (command, "|", &save_ptr); stage != NULL;
+       stage = strtok_r (NULL, "|", &save_ptr))
+    {
+      if (stage_cnt >= MAX_STAGES)
+        {
+          printf ("too many commands in pipeline\n");
+          return;
+        }
+      stages[stage_cnt++] = stage;
+    }
+
+  /* Each command inherits our standard input and output, so
+     point them at the right pipe ends while starting it, then
+     put them back. */
+  saved_in = dup (STDIN_FILENO);
+  saved_out = dup (STDOUT_FILENO);
+  for (i = 0; i < stage_cnt; i++)
+    {
+      bool last = i == stage_cnt - 1;
+      int fds[2];
+
+      if (!last && !pipe (fds))
+        {
+          stage_cnt = i;
+          break;
+        }
+      dup2 (in_fd >= 0 ? in_fd : saved_in, STDIN_FILENO);
+      dup2 (last ? saved_out : fds[1], STDOUT_FILENO);
+      pids[i] = exec (stages[i]);
+
+      /* Only the commands may keep the pipe ends open, or the
+         reader of a pipe would never see end of file. */
+      if (in_fd >= 0)
+        close (in_fd);
+      in_fd = -1;
+      if (!last)
+        {
+          close (fds[1]);
+          in_fd = fds[0];
+        }
+    }
+  dup2 (saved_in, STDIN_FILENO);
+  dup2 (saved_out, STDOUT_FILENO);
+  close (saved_in);
+  close (saved_out);
+  if (in_fd >= 0)
+    {
+      /* pipe() failed partway. */
+      close (in_fd);
+      printf ("pipe failed\n");
+    }
+
+  for (i = 0; i < stage_cnt; i++)
+    if (pids[i] != PID_ERROR)
+      printf ("\"%s\": exit code %d\n", stages[i], wait (pids[i]));
+    else
+      printf ("\"%s\": exec failed\n", stages[i]);
+}
+
 /* Reads a line of input from the user into LINE, which has room
    for SIZE bytes.  Handles backspace and Ctrl+U in the ways
    expected by Unix users.  On return, LINE will always be
@@ -113,6 +113,19 @@ file_write_at (struct file *file, const void *buffer, off_t size,
   return inode_write_at (file->inode, buffer, size, file_ofs);
 }
 
+/* Copies SIZE bytes from SRC, starting at byte offset SRC_OFS,
+   into DST, starting at byte offset DST_OFS, without going
+   through the caller's memory.  Returns the number of bytes
+   actually copied, which may be less than SIZE if end of either
+   file is reached.  Neither file's current position is
+   affected. */
+off_t
+file_copy_at (struct file *dst, off_t dst_ofs,
+              struct file *src, off_t src_ofs, off_t size)
+{
+  return inode_copy_at (dst->inode, dst_ofs, src->inode, src_ofs, size);
+}
+
 /* Prevents write operations on FILE's underlying inode
    until file_allow_write() is called or FILE is closed. */
 void
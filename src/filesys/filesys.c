@@ -6,10 +6,15 @@
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
+#include "threads/synch.h"
 
 /* Partition that contains the file system. */
 struct block *fs_device;
 
+/* Serializes access to the file system, whose code is not
+   otherwise safe to run in more than one thread at a time. */
+struct lock filesys_lock;
+
 static void do_format (void);
 
 /* Initializes the file system module.
@@ -21,6 +26,8 @@ filesys_init (bool format)
   if (fs_device == NULL)
     PANIC ("No file system device found, can't initialize file system.");
 
+  lock_init (&filesys_lock);
+
   inode_init ();
   free_map_init ();
 
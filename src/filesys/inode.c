@@ -6,6 +6,7 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -36,6 +37,8 @@ struct inode
     int open_cnt;                       /* Number of openers. */
     bool removed;                       /* True if deleted, false otherwise. */
     int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+    unsigned version;                   /* Changed by every write. */
+    struct lock io_lock;                /* See inode_lock(). */
     struct inode_disk data;             /* Inode content. */
   };
 
@@ -136,7 +139,9 @@ inode_open (block_sector_t sector)
   inode->sector = sector;
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
+  inode->version = 0;
   inode->removed = false;
+  lock_init (&inode->io_lock);
   block_read (fs_device, inode->sector, &inode->data);
   return inode;
 }
@@ -264,6 +269,8 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 
   if (inode->deny_write_cnt)
     return 0;
+  if (size > 0)
+    inode->version++;
 
   while (size > 0) 
     {
@@ -317,6 +324,52 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
   return bytes_written;
 }
 
+/* Copies SIZE bytes from SRC, starting at SRC_OFS, into DST,
+   starting at DST_OFS, a piece at a time through a one-sector
+   kernel buffer.  Each piece ends at a sector boundary in SRC,
+   so when both offsets are sector-aligned every piece is a whole
+   sector, copied with one sector read and one sector write.
+   Otherwise, writing a piece into part of a sector of DST also
+   reads that sector first.  Returns the number of bytes actually
+   copied, which may be less than SIZE if end of either file is
+   reached or an error occurs.  The ranges must not overlap if
+   SRC and DST are the same inode.
+
+   Sectors always belong to exactly one inode, so there is no
+   way to share them between files instead of copying. */
+off_t
+inode_copy_at (struct inode *dst, off_t dst_ofs,
+               struct inode *src, off_t src_ofs, off_t size)
+{
+  uint8_t *buffer;
+  off_t bytes_copied = 0;
+
+  buffer = malloc (BLOCK_SECTOR_SIZE);
+  if (buffer == NULL)
+    return 0;
+
+  while (size > 0)
+    {
+      int sector_left = BLOCK_SECTOR_SIZE - src_ofs % BLOCK_SECTOR_SIZE;
+      off_t chunk_size = size < sector_left ? size : sector_left;
+      off_t bytes_read = inode_read_at (src, buffer, chunk_size, src_ofs);
+      off_t bytes_written = inode_write_at (dst, buffer, bytes_read,
+                                            dst_ofs);
+
+      bytes_copied += bytes_written;
+      if (bytes_written < chunk_size)
+        break;
+
+      /* Advance. */
+      size -= chunk_size;
+      src_ofs += chunk_size;
+      dst_ofs += chunk_size;
+    }
+  free (buffer);
+
+  return bytes_copied;
+}
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 void
@@ -337,6 +390,34 @@ inode_allow_write (struct inode *inode)
   inode->deny_write_cnt--;
 }
 
+/* Acquires INODE's I/O lock, which a read or write that takes
+   several calls to inode_read_at() or inode_write_at() holds
+   across all of them, so that other such reads and writes of
+   INODE see it either done or not begun.  User pages may be
+   brought in while it is held, so it must be acquired before
+   filesys_lock. */
+void
+inode_lock (struct inode *inode)
+{
+  lock_acquire (&inode->io_lock);
+}
+
+/* Releases INODE's I/O lock. */
+void
+inode_unlock (struct inode *inode)
+{
+  lock_release (&inode->io_lock);
+}
+
+/* Returns INODE's version, which changes whenever INODE's data
+   may have changed, so that copies of the data kept elsewhere
+   can tell whether they are still current. */
+unsigned
+inode_version (const struct inode *inode)
+{
+  return inode->version;
+}
+
 /* Returns the length, in bytes, of INODE's data. */
 off_t
 inode_length (const struct inode *inode)
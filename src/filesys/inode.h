@@ -16,8 +16,13 @@ void inode_close (struct inode *);
 void inode_remove (struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+off_t inode_copy_at (struct inode *dst, off_t dst_ofs,
+                     struct inode *src, off_t src_ofs, off_t size);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
+void inode_lock (struct inode *);
+void inode_unlock (struct inode *);
+unsigned inode_version (const struct inode *);
 off_t inode_length (const struct inode *);
 
 #endif /* filesys/inode.h */
@@ -0,0 +1,15 @@
+#ifndef __LIB_IPC_H
+#define __LIB_IPC_H
+
+/* Number of words in an IPC message.  A message travels in
+   registers %ebx, %esi, and %edi, in that order, in both
+   directions. */
+#define IPC_MSG_WORDS 3
+
+/* A short message for ipc_call() and ipc_reply_wait(). */
+struct ipc_msg
+  {
+    unsigned w[IPC_MSG_WORDS];  /* Message words. */
+  };
+
+#endif /* lib/ipc.h */
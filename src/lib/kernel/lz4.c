@@ -0,0 +1,212 @@
+#include "lz4.h"
+#include <debug.h>
+#include <string.h>
+
+/* An LZ4 block is a series of sequences.  Each sequence is a
+   token byte, whose high and low nibbles give the number of
+   literals and the length of the match that follow, then the
+   literals, then the match as a 2-byte little-endian offset back
+   into the output.  A nibble of 15 means that the length goes
+   on in extra bytes of 255 each, ending in one less than 255,
+   which come right after the token (for literals) or the offset
+   (for the match).  Matches are at least MIN_MATCH bytes long,
+   so the match nibble stores the length minus MIN_MATCH.  The
+   last sequence consists of literals only. */
+
+/* Shortest match. */
+#define MIN_MATCH 4
+
+/* The last match must start at least MFLIMIT bytes before the
+   end of the input, and the last LAST_LITERALS bytes are always
+   literals, as the LZ4 format requires. */
+#define MFLIMIT 12
+#define LAST_LITERALS 5
+
+/* Farthest back a match can be. */
+#define MAX_OFFSET 65535
+
+/* Returns the 4 bytes at P as an integer. */
+static inline uint32_t
+read32 (const uint8_t *p)
+{
+  uint32_t v;
+  memcpy (&v, p, sizeof v);
+  return v;
+}
+
+/* Returns the hash table index for the 4 bytes V. */
+static inline unsigned
+hash4 (uint32_t v)
+{
+  return (v * 2654435761u) >> (32 - 10);
+}
+
+/* Stores the part of length LEN that doesn't fit in a token
+   nibble at OP, and returns the byte after it.  LEN must be at
+   least 15. */
+static uint8_t *
+put_length (uint8_t *op, size_t len)
+{
+  for (len -= 15; len >= 255; len -= 255)
+    *op++ = 255;
+  *op++ = len;
+  return op;
+}
+
+/* Appends a sequence of the LIT_LEN literals at LIT followed by a
+   MATCH_LEN-byte match OFFSET bytes back, or only the literals
+   if MATCH_LEN is 0, at OP, which must not go past OEND.  Returns
+   the byte after the sequence, or a null pointer if it doesn't
+   fit. */
+static uint8_t *
+put_sequence (uint8_t *op, uint8_t *oend, const uint8_t *lit,
+              size_t lit_len, size_t offset, size_t match_len)
+{
+  size_t match_code = match_len > 0 ? match_len - MIN_MATCH : 0;
+  uint8_t *token;
+
+  if ((size_t) (oend - op) < (1 + lit_len / 255 + 1 + lit_len
+                              + 2 + match_code / 255 + 1))
+    return NULL;
+
+  token = op++;
+  *token = (lit_len < 15 ? lit_len : 15) << 4;
+  if (lit_len >= 15)
+    op = put_length (op, lit_len);
+  memcpy (op, lit, lit_len);
+  op += lit_len;
+
+  if (match_len > 0)
+    {
+      *op++ = offset & 0xff;
+      *op++ = offset >> 8;
+      *token |= match_code < 15 ? match_code : 15;
+      if (match_code >= 15)
+        op = put_length (op, match_code);
+    }
+  return op;
+}
+
+/* Compresses the SRC_SIZE bytes at SRC into the DST_SIZE bytes at
+   DST, using TABLE as scratch space.  Returns the size of the
+   compressed data, or 0 if it doesn't fit in DST_SIZE bytes. */
+size_t
+lz4_compress (const void *src_, size_t src_size, void *dst_, size_t dst_size,
+              uint16_t table[LZ4_TABLE_SIZE])
+{
+  const uint8_t *src = src_;
+  const uint8_t *end = src + src_size;
+  const uint8_t *ip = src;
+  const uint8_t *anchor = src;
+  uint8_t *dst = dst_;
+  uint8_t *op = dst;
+  uint8_t *oend = dst + dst_size;
+
+  ASSERT (src_size <= LZ4_MAX_INPUT);
+
+  memset (table, 0, LZ4_TABLE_SIZE * sizeof *table);
+  if (src_size > MFLIMIT)
+    {
+      const uint8_t *mflimit = end - MFLIMIT;
+      const uint8_t *match_limit = end - LAST_LITERALS;
+
+      while (ip < mflimit)
+        {
+          uint32_t v = read32 (ip);
+          unsigned h = hash4 (v);
+          const uint8_t *ref = src + table[h];
+          const uint8_t *mp;
+
+          table[h] = ip - src;
+          if (ref >= ip || ip - ref > MAX_OFFSET || read32 (ref) != v)
+            {
+              ip++;
+              continue;
+            }
+
+          /* Extend the match as far as it goes. */
+          for (mp = ip + MIN_MATCH; mp < match_limit && *mp == ref[mp - ip];
+               mp++)
+            continue;
+
+          op = put_sequence (op, oend, anchor, ip - anchor, ip - ref,
+                             mp - ip);
+          if (op == NULL)
+            return 0;
+          ip = anchor = mp;
+        }
+    }
+
+  op = put_sequence (op, oend, anchor, end - anchor, 0, 0);
+  return op != NULL ? (size_t) (op - dst) : 0;
+}
+
+/* Reads the part of a length that doesn't fit in a token nibble
+   from *IP, which must not go past IEND, adding it to *LEN and
+   advancing *IP.  Returns false if the input ends first. */
+static bool
+get_length (const uint8_t **ip, const uint8_t *iend, size_t *len)
+{
+  uint8_t b;
+
+  do
+    {
+      if (*ip >= iend)
+        return false;
+      b = *(*ip)++;
+      *len += b;
+    }
+  while (b == 255);
+  return true;
+}
+
+/* Decompresses the SRC_SIZE bytes of LZ4 block data at SRC into
+   the DST_SIZE bytes at DST.  Returns true if successful, false
+   if SRC is corrupt or doesn't decompress to exactly DST_SIZE
+   bytes. */
+bool
+lz4_decompress (const void *src_, size_t src_size, void *dst_, size_t dst_size)
+{
+  const uint8_t *ip = src_;
+  const uint8_t *iend = ip + src_size;
+  uint8_t *dst = dst_;
+  uint8_t *op = dst;
+  uint8_t *oend = dst + dst_size;
+
+  while (ip < iend)
+    {
+      uint8_t token = *ip++;
+      size_t len, offset;
+      const uint8_t *ref;
+
+      /* Literals. */
+      len = token >> 4;
+      if (len == 15 && !get_length (&ip, iend, &len))
+        return false;
+      if (len > (size_t) (iend - ip) || len > (size_t) (oend - op))
+        return false;
+      memcpy (op, ip, len);
+      op += len;
+      ip += len;
+      if (ip == iend)
+        break;
+
+      /* Match.  It may overlap the bytes it produces, so copy it
+         a byte at a time. */
+      if (iend - ip < 2)
+        return false;
+      offset = ip[0] | (ip[1] << 8);
+      ip += 2;
+      if (offset == 0 || offset > (size_t) (op - dst))
+        return false;
+      len = token & 15;
+      if (len == 15 && !get_length (&ip, iend, &len))
+        return false;
+      len += MIN_MATCH;
+      if (len > (size_t) (oend - op))
+        return false;
+      for (ref = op - offset; len > 0; len--)
+        *op++ = *ref++;
+    }
+  return op == oend;
+}
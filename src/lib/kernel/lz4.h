@@ -0,0 +1,26 @@
+#ifndef __LIB_KERNEL_LZ4_H
+#define __LIB_KERNEL_LZ4_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* LZ4 block compression.
+
+   Produces and consumes the LZ4 block format, without the frame
+   format's headers and checksums.  Inputs are limited to 64 kB,
+   which is plenty for compressing pages one at a time. */
+
+/* Largest input that lz4_compress() accepts. */
+#define LZ4_MAX_INPUT 65536
+
+/* Number of entries in the hash table passed to lz4_compress(). */
+#define LZ4_TABLE_SIZE 1024
+
+size_t lz4_compress (const void *src, size_t src_size,
+                     void *dst, size_t dst_size,
+                     uint16_t table[LZ4_TABLE_SIZE]);
+bool lz4_decompress (const void *src, size_t src_size,
+                     void *dst, size_t dst_size);
+
+#endif /* lib/kernel/lz4.h */
@@ -0,0 +1,17 @@
+#ifndef __LIB_MEMSTAT_H
+#define __LIB_MEMSTAT_H
+
+/* Memory and paging statistics for a process, as returned by
+   the memstat system call.  Everything but RESIDENT counts
+   events since the process started. */
+struct memstat
+  {
+    unsigned long resident;     /* Pages currently in frames. */
+    unsigned long minor_faults; /* Faults resolved without I/O. */
+    unsigned long major_faults; /* Faults that read a file or swap. */
+    unsigned long swap_ins;     /* Pages read back from swap. */
+    unsigned long swap_outs;    /* Pages written to swap. */
+    unsigned long cow_copies;   /* Pages copied on write. */
+  };
+
+#endif /* lib/memstat.h */
@@ -0,0 +1,28 @@
+#ifndef __LIB_POLL_H
+#define __LIB_POLL_H
+
+/* One object for poll() to watch. */
+struct pollfd
+  {
+    int fd;                     /* File descriptor, or child's pid. */
+    short events;               /* Events of interest. */
+    short revents;              /* Events that occurred. */
+  };
+
+/* Events.  POLLERR, POLLHUP, and POLLNVAL are reported in
+   `revents' whether or not they are requested in `events'. */
+#define POLLIN    0x001         /* Data can be read without blocking. */
+#define POLLOUT   0x004         /* Data can be written without blocking. */
+#define POLLERR   0x008         /* Pipe has no read end left open. */
+#define POLLHUP   0x010         /* Pipe has no write end left open. */
+#define POLLNVAL  0x020         /* `fd' is not open or not a child. */
+
+/* In `events' only: `fd' holds the pid of a child of the calling
+   process instead of a file descriptor, and POLLIN means that the
+   child has exited, so that wait() for it will not block. */
+#define POLLCHILD 0x100
+
+/* Maximum number of objects in one poll(). */
+#define POLL_MAX 64
+
+#endif /* lib/poll.h */
@@ -0,0 +1,107 @@
+#ifndef __LIB_RING_H
+#define __LIB_RING_H
+
+/* Submission and completion rings for batched system calls.
+
+   A process sets up a ring with ring_setup(), which maps a page
+   shared with the kernel at an address of the process's choice.
+   The process queues requests by filling in entries of `sq' and
+   advancing `sq_tail', then calls ring_enter() to hand any number
+   of them to the kernel at once.  The kernel reports each
+   request's result by filling in an entry of `cq' and advancing
+   `cq_tail', and the process consumes results by advancing
+   `cq_head'.  Heads and tails run freely and are reduced modulo
+   RING_ENTRIES to index the arrays.
+
+   Reads and writes run asynchronously on kernel worker threads,
+   but the requests submitted through a ring always run in the
+   order they were submitted, so a read may be followed by a write
+   of the same buffer in a single batch.  A read or write moves at
+   most RING_IO_MAX bytes, like a short read or write.  Reads and
+   writes of pipes, which could hold up a worker indefinitely, are
+   not supported and fail with result -1. */
+
+/* Number of entries in each ring.  Must be a power of 2. */
+#define RING_ENTRIES 64
+
+/* Maximum number of bytes moved by one read or write. */
+#define RING_IO_MAX 4096
+
+/* Request types. */
+enum ring_op
+  {
+    RING_READ,                  /* read (fd, buf, size). */
+    RING_WRITE,                 /* write (fd, buf, size). */
+    RING_OPEN,                  /* open (buf). */
+    RING_CLOSE,                 /* close (fd). */
+    RING_SEEK                   /* seek (fd, size). */
+  };
+
+/* Submission queue entry. */
+struct ring_sqe
+  {
+    int op;                     /* One of enum ring_op. */
+    int fd;                     /* File descriptor. */
+    void *buf;                  /* Data buffer, or file name to open. */
+    unsigned size;              /* Bytes to move, or seek position. */
+    unsigned user_data;         /* Copied to the completion entry. */
+  };
+
+/* Completion queue entry. */
+struct ring_cqe
+  {
+    unsigned user_data;         /* From the submission entry. */
+    int result;                 /* What the system call would return. */
+  };
+
+/* Shared ring page. */
+struct ring
+  {
+    volatile unsigned sq_head;  /* Next entry for kernel to take. */
+    volatile unsigned sq_tail;  /* Next entry for process to fill. */
+    volatile unsigned cq_head;  /* Next entry for process to take. */
+    volatile unsigned cq_tail;  /* Next entry for kernel to fill. */
+    struct ring_sqe sq[RING_ENTRIES];
+    struct ring_cqe cq[RING_ENTRIES];
+  };
+
+/* Returns the next free submission entry in RING, or a null
+   pointer if the submission ring is full.  Fill it in, then
+   call ring_push() to queue it. */
+static inline struct ring_sqe *
+ring_next_sqe (struct ring *ring)
+{
+  if (ring->sq_tail - ring->sq_head >= RING_ENTRIES)
+    return 0;
+  return &ring->sq[ring->sq_tail % RING_ENTRIES];
+}
+
+/* Queues the entry returned by ring_next_sqe(). */
+static inline void
+ring_push (struct ring *ring)
+{
+  asm volatile ("" : : : "memory");
+  ring->sq_tail++;
+}
+
+/* Returns the oldest unconsumed completion entry in RING, or a
+   null pointer if there is none.  Call ring_pop() when done
+   with it. */
+static inline struct ring_cqe *
+ring_peek_cqe (struct ring *ring)
+{
+  if (ring->cq_head == ring->cq_tail)
+    return 0;
+  asm volatile ("" : : : "memory");
+  return &ring->cq[ring->cq_head % RING_ENTRIES];
+}
+
+/* Consumes the entry returned by ring_peek_cqe(). */
+static inline void
+ring_pop (struct ring *ring)
+{
+  asm volatile ("" : : : "memory");
+  ring->cq_head++;
+}
+
+#endif /* lib/ring.h */
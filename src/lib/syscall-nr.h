@@ -28,7 +28,28 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_FORK,                   /* Duplicate the calling process. */
+    SYS_MSYNC,                  /* Write back a memory mapping. */
+    SYS_MEMSTAT,                /* Get memory statistics. */
+    SYS_RING_SETUP,             /* Set up a submission ring. */
+    SYS_RING_ENTER,             /* Submit and reap ring requests. */
+    SYS_READV,                  /* Read into several buffers. */
+    SYS_WRITEV,                 /* Write from several buffers. */
+    SYS_PREAD,                  /* Read at a given position. */
+    SYS_PWRITE,                 /* Write at a given position. */
+    SYS_COPY_FILE_RANGE,        /* Copy data between files. */
+    SYS_PIPE,                   /* Create a pipe. */
+    SYS_DUP,                    /* Duplicate a file descriptor. */
+    SYS_DUP2,                   /* Duplicate onto a given descriptor. */
+    SYS_IPC_CALL,               /* Send a message and await the reply. */
+    SYS_IPC_REPLY_WAIT,         /* Reply and await the next message. */
+    SYS_POLL,                   /* Wait for any of several objects. */
+    SYS_SHM_CREATE,             /* Create a shared memory segment. */
+    SYS_SHM_MAP,                /* Map a shared memory segment. */
+    SYS_SHM_UNMAP               /* Unmap a shared memory segment. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,16 @@
+#ifndef __LIB_UIO_H
+#define __LIB_UIO_H
+
+#include <stddef.h>
+
+/* One buffer in a scatter-gather list for readv and writev. */
+struct iovec
+  {
+    void *iov_base;             /* Start of buffer. */
+    size_t iov_len;             /* Length of buffer, in bytes. */
+  };
+
+/* Maximum number of buffers in one readv or writev. */
+#define IOV_MAX 16
+
+#endif /* lib/uio.h */
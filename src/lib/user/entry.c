@@ -2,9 +2,11 @@
 
 int main (int, char *[]);
 void _start (int argc, char *argv[]);
+void syscall_probe (void);
 
 void
 _start (int argc, char *argv[]) 
 {
+  syscall_probe ();
   exit (main (argc, argv));
 }
@@ -1,31 +1,61 @@
 #include <syscall.h>
 #include "../syscall-nr.h"
 
+/* Nonzero if the CPU supports SYSENTER, set by syscall_probe(). */
+static int use_sysenter;
+
+void syscall_probe (void);
+
+/* Decides how to make system calls.  Called by _start() before
+   main().  SYSENTER saves no state, so it is much faster than
+   "int $0x30", but not every CPU has it. */
+void
+syscall_probe (void)
+{
+  /* See [IA32-v2a] "CPUID".  Bit 11 of EDX is SEP. */
+  unsigned int eax = 1, ebx, ecx, edx;
+  asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+  use_sysenter = (edx & (1u << 11)) != 0;
+}
+
+/* Traps into the kernel, with the system call number and its
+   arguments already pushed on the stack.  Uses SYSENTER if
+   possible, passing the stack pointer in %ecx and the return
+   address in %edx; the kernel returns to label 1 with the stack
+   pointer unchanged.  Otherwise falls back to "int $0x30". */
+#define SYSCALL_TRAP                                            \
+        "cmpl $0, %[fast]; je 2f; "                             \
+        "movl %%esp, %%ecx; movl $1f, %%edx; sysenter; "        \
+        "2: int $0x30; 1: "
+
 /* Invokes syscall NUMBER, passing no arguments, and returns the
    return value as an `int'. */
 #define syscall0(NUMBER)                                        \
         ({                                                      \
           int retval;                                           \
           asm volatile                                          \
-            ("pushl %[number]; int $0x30; addl $4, %%esp"       \
+            ("pushl %[number]; " SYSCALL_TRAP "addl $4, %%esp"  \
                : "=a" (retval)                                  \
-               : [number] "i" (NUMBER)                          \
-               : "memory");                                     \
+               : [number] "i" (NUMBER),                         \
+                 [fast] "m" (use_sysenter)                      \
+               : "ecx", "edx", "memory");                       \
           retval;                                               \
         })
 
 /* Invokes syscall NUMBER, passing argument ARG0, and returns the
    return value as an `int'. */
-#define syscall1(NUMBER, ARG0)                                           \
-        ({                                                               \
-          int retval;                                                    \
-          asm volatile                                                   \
-            ("pushl %[arg0]; pushl %[number]; int $0x30; addl $8, %%esp" \
-               : "=a" (retval)                                           \
-               : [number] "i" (NUMBER),                                  \
-                 [arg0] "g" (ARG0)                                       \
-               : "memory");                                              \
-          retval;                                                        \
+#define syscall1(NUMBER, ARG0)                                  \
+        ({                                                      \
+          int retval;                                           \
+          asm volatile                                          \
+            ("pushl %[arg0]; pushl %[number]; "                 \
+             SYSCALL_TRAP "addl $8, %%esp"                      \
+               : "=a" (retval)                                  \
+               : [number] "i" (NUMBER),                         \
+                 [arg0] "g" (ARG0),                             \
+                 [fast] "m" (use_sysenter)                      \
+               : "ecx", "edx", "memory");                       \
+          retval;                                               \
         })
 
 /* Invokes syscall NUMBER, passing arguments ARG0 and ARG1, and
@@ -35,12 +65,13 @@
           int retval;                                           \
           asm volatile                                          \
             ("pushl %[arg1]; pushl %[arg0]; "                   \
-             "pushl %[number]; int $0x30; addl $12, %%esp"      \
+             "pushl %[number]; " SYSCALL_TRAP "addl $12, %%esp" \
                : "=a" (retval)                                  \
                : [number] "i" (NUMBER),                         \
                  [arg0] "r" (ARG0),                             \
-                 [arg1] "r" (ARG1)                              \
-               : "memory");                                     \
+                 [arg1] "r" (ARG1),                             \
+                 [fast] "m" (use_sysenter)                      \
+               : "ecx", "edx", "memory");                       \
           retval;                                               \
         })
 
@@ -51,13 +82,81 @@
           int retval;                                           \
           asm volatile                                          \
             ("pushl %[arg2]; pushl %[arg1]; pushl %[arg0]; "    \
-             "pushl %[number]; int $0x30; addl $16, %%esp"      \
+             "pushl %[number]; " SYSCALL_TRAP "addl $16, %%esp" \
                : "=a" (retval)                                  \
                : [number] "i" (NUMBER),                         \
                  [arg0] "r" (ARG0),                             \
                  [arg1] "r" (ARG1),                             \
-                 [arg2] "r" (ARG2)                              \
-               : "memory");                                     \
+                 [arg2] "r" (ARG2),                             \
+                 [fast] "m" (use_sysenter)                      \
+               : "ecx", "edx", "memory");                       \
+          retval;                                               \
+        })
+
+/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, ARG2,
+   and ARG3, and returns the return value as an `int'. */
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                \
+        ({                                                      \
+          int retval;                                           \
+          asm volatile                                          \
+            ("pushl %[arg3]; pushl %[arg2]; pushl %[arg1]; "    \
+             "pushl %[arg0]; pushl %[number]; "                 \
+             SYSCALL_TRAP "addl $20, %%esp"                     \
+               : "=a" (retval)                                  \
+               : [number] "i" (NUMBER),                         \
+                 [arg0] "r" (ARG0),                             \
+                 [arg1] "r" (ARG1),                             \
+                 [arg2] "r" (ARG2),                             \
+                 [arg3] "g" (ARG3),                             \
+                 [fast] "m" (use_sysenter)                      \
+               : "ecx", "edx", "memory");                       \
+          retval;                                               \
+        })
+
+/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, ARG2,
+   ARG3, and ARG4, and returns the return value as an `int'.
+   Only the first argument pushed may be a memory operand, which
+   might be relative to %esp; every push moves %esp. */
+#define syscall5(NUMBER, ARG0, ARG1, ARG2, ARG3, ARG4)          \
+        ({                                                      \
+          int retval;                                           \
+          asm volatile                                          \
+            ("pushl %[arg4]; pushl %[arg3]; pushl %[arg2]; "    \
+             "pushl %[arg1]; pushl %[arg0]; pushl %[number]; "  \
+             SYSCALL_TRAP "addl $24, %%esp"                     \
+               : "=a" (retval)                                  \
+               : [number] "i" (NUMBER),                         \
+                 [arg0] "r" (ARG0),                             \
+                 [arg1] "r" (ARG1),                             \
+                 [arg2] "r" (ARG2),                             \
+                 [arg3] "r" (ARG3),                             \
+                 [arg4] "g" (ARG4),                             \
+                 [fast] "m" (use_sysenter)                      \
+               : "ecx", "edx", "memory");                       \
+          retval;                                               \
+        })
+
+/* Invokes IPC syscall NUMBER, passing argument ARG0 and the
+   words of struct ipc_msg *MSG in %ebx, %esi, and %edi, and
+   returns the return value as an `int'.  The kernel's message
+   comes back in the same registers and replaces *MSG. */
+#define syscall_ipc(NUMBER, ARG0, MSG)                          \
+        ({                                                      \
+          struct ipc_msg *msg_ = (MSG);                         \
+          unsigned w0 = msg_->w[0], w1 = msg_->w[1];            \
+          unsigned w2 = msg_->w[2];                             \
+          int retval;                                           \
+          asm volatile                                          \
+            ("pushl %[arg0]; pushl %[number]; "                 \
+             SYSCALL_TRAP "addl $8, %%esp"                      \
+               : "=a" (retval), "+b" (w0), "+S" (w1), "+D" (w2) \
+               : [number] "i" (NUMBER),                         \
+                 [arg0] "g" (ARG0),                             \
+                 [fast] "m" (use_sysenter)                      \
+               : "ecx", "edx", "memory");                       \
+          msg_->w[0] = w0;                                      \
+          msg_->w[1] = w1;                                      \
+          msg_->w[2] = w2;                                      \
           retval;                                               \
         })
 
@@ -182,3 +281,119 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+pid_t
+fork (void)
+{
+  return syscall0 (SYS_FORK);
+}
+
+bool
+msync (mapid_t mapid)
+{
+  return syscall1 (SYS_MSYNC, mapid);
+}
+
+bool
+memstat (struct memstat *stats)
+{
+  return syscall1 (SYS_MEMSTAT, stats);
+}
+
+bool
+ring_setup (struct ring *ring)
+{
+  return syscall1 (SYS_RING_SETUP, ring);
+}
+
+int
+ring_enter (unsigned to_submit, unsigned min_complete)
+{
+  return syscall2 (SYS_RING_ENTER, to_submit, min_complete);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, unsigned offset)
+{
+  return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, unsigned offset)
+{
+  return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int
+copy_file_range (int in_fd, int in_offset, int out_fd, int out_offset,
+                 unsigned length)
+{
+  return syscall5 (SYS_COPY_FILE_RANGE, in_fd, in_offset, out_fd,
+                   out_offset, length);
+}
+
+bool
+pipe (int fds[2])
+{
+  return syscall1 (SYS_PIPE, fds);
+}
+
+int
+dup (int fd)
+{
+  return syscall1 (SYS_DUP, fd);
+}
+
+int
+dup2 (int old_fd, int new_fd)
+{
+  return syscall2 (SYS_DUP2, old_fd, new_fd);
+}
+
+int
+ipc_call (pid_t server, struct ipc_msg *msg)
+{
+  return syscall_ipc (SYS_IPC_CALL, server, msg);
+}
+
+pid_t
+ipc_reply_wait (pid_t client, struct ipc_msg *msg)
+{
+  return syscall_ipc (SYS_IPC_REPLY_WAIT, client, msg);
+}
+
+int
+poll (struct pollfd *fds, unsigned nfds, int timeout)
+{
+  return syscall3 (SYS_POLL, fds, nfds, timeout);
+}
+
+int
+shm_create (unsigned size)
+{
+  return syscall1 (SYS_SHM_CREATE, size);
+}
+
+void *
+shm_map (int handle, void *addr)
+{
+  return (void *) syscall2 (SYS_SHM_MAP, handle, addr);
+}
+
+bool
+shm_unmap (void *addr)
+{
+  return syscall1 (SYS_SHM_UNMAP, addr);
+}
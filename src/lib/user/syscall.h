@@ -3,6 +3,11 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <ipc.h>
+#include <memstat.h>
+#include <poll.h>
+#include <ring.h>
+#include <uio.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -45,4 +50,26 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+pid_t fork (void);
+bool msync (mapid_t);
+bool memstat (struct memstat *);
+bool ring_setup (struct ring *);
+int ring_enter (unsigned to_submit, unsigned min_complete);
+int readv (int fd, const struct iovec *, int iovcnt);
+int writev (int fd, const struct iovec *, int iovcnt);
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+int copy_file_range (int in_fd, int in_offset, int out_fd, int out_offset,
+                     unsigned length);
+bool pipe (int fds[2]);
+int dup (int fd);
+int dup2 (int old_fd, int new_fd);
+int ipc_call (pid_t server, struct ipc_msg *);
+pid_t ipc_reply_wait (pid_t client, struct ipc_msg *);
+int poll (struct pollfd *, unsigned nfds, int timeout);
+int shm_create (unsigned size);
+void *shm_map (int handle, void *addr);
+bool shm_unmap (void *addr);
+
 #endif /* lib/user/syscall.h */
@@ -0,0 +1,20 @@
+/* Passes sizes and positions of 2 GB and more, which do not fit
+   in a file offset, to create() and seek().  The kernel must
+   refuse them rather than panic. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char buf;
+  int fd;
+
+  CHECK (!create ("quux.dat", 0x80000000), "create with huge size");
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  seek (fd, 0xffffffff);
+  CHECK (tell (fd) == 0, "seek to huge position is ignored");
+  CHECK (read (fd, &buf, 1) == 1, "read \"sample.txt\"");
+}
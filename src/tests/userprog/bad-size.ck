@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(bad-size) begin
+(bad-size) create with huge size
+(bad-size) open "sample.txt"
+(bad-size) seek to huge position is ignored
+(bad-size) read "sample.txt"
+(bad-size) end
+bad-size: exit(0)
+EOF
+pass;
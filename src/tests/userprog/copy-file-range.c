@@ -0,0 +1,43 @@
+/* Copies a file into another with copy_file_range, first in two
+   pieces using the file positions and then in one piece at
+   explicit offsets, and verifies the result.  Also checks that
+   copying between overlapping ranges of one file, or to a range
+   that would end past the largest file offset, is refused. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  int size = sizeof sample - 1;
+  char buf[sizeof sample];
+  int in, out;
+
+  CHECK (create ("copy.dat", size), "create \"copy.dat\"");
+  CHECK ((in = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((out = open ("copy.dat")) > 1, "open \"copy.dat\"");
+
+  CHECK (copy_file_range (in, -1, out, -1, 100) == 100,
+         "copy first 100 bytes");
+  CHECK (copy_file_range (in, -1, out, -1, size) == size - 100,
+         "copy the rest");
+  CHECK (tell (in) == (unsigned) size && tell (out) == (unsigned) size,
+         "positions advanced");
+  CHECK (read (out, buf, 1) == 0, "nothing left to read");
+  CHECK (pread (out, buf, size, 0) == size, "read \"copy.dat\"");
+  CHECK (!memcmp (buf, sample, size), "compare copy against original");
+
+  CHECK (copy_file_range (in, 0, out, 0, size) == size,
+         "copy again at explicit offsets");
+  CHECK (tell (out) == (unsigned) size, "position unchanged");
+  CHECK (copy_file_range (out, 0, out, 10, 20) == -1,
+         "overlapping copy refused");
+  CHECK (copy_file_range (out, 0, out, 0x7ffffff0, 20) == -1,
+         "copy past largest offset refused");
+  close (in);
+  close (out);
+}
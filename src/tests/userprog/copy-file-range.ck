@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-file-range) begin
+(copy-file-range) create "copy.dat"
+(copy-file-range) open "sample.txt"
+(copy-file-range) open "copy.dat"
+(copy-file-range) copy first 100 bytes
+(copy-file-range) copy the rest
+(copy-file-range) positions advanced
+(copy-file-range) nothing left to read
+(copy-file-range) read "copy.dat"
+(copy-file-range) compare copy against original
+(copy-file-range) copy again at explicit offsets
+(copy-file-range) position unchanged
+(copy-file-range) overlapping copy refused
+(copy-file-range) copy past largest offset refused
+(copy-file-range) end
+copy-file-range: exit(0)
+EOF
+pass;
@@ -0,0 +1,64 @@
+/* Forks a server that adds the words of each message it gets
+   and replies with the sum, and makes a few calls to it.  Checks
+   that a bad reply is refused, and that a call fails once the
+   server has exited. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Number of calls to make. */
+#define CALLS 100
+
+/* Serves calls until it gets a message whose first word is 0,
+   then exits without replying. */
+static void
+serve (void)
+{
+  struct ipc_msg m;
+  pid_t client;
+
+  /* Process 1 is not waiting for a reply from us. */
+  if (ipc_reply_wait (1, &m) != PID_ERROR)
+    exit (1);
+
+  client = ipc_reply_wait (PID_ERROR, &m);
+  while (client != PID_ERROR && m.w[0] != 0)
+    {
+      m.w[2] = m.w[0] + m.w[1];
+      m.w[0] = m.w[1] = 0;
+      client = ipc_reply_wait (client, &m);
+    }
+  exit (0x42);
+}
+
+void
+test_main (void)
+{
+  struct ipc_msg m;
+  pid_t server;
+  unsigned i;
+
+  CHECK ((server = fork ()) != PID_ERROR, "fork");
+  if (server == 0)
+    serve ();
+
+  for (i = 1; i <= CALLS; i++)
+    {
+      m.w[0] = i;
+      m.w[1] = 1000 * i;
+      m.w[2] = 0;
+      if (ipc_call (server, &m) != 0)
+        fail ("call %u failed", i);
+      if (m.w[0] != 0 || m.w[1] != 0 || m.w[2] != 1001 * i)
+        fail ("call %u got reply %u %u %u",
+              i, m.w[0], m.w[1], m.w[2]);
+    }
+  msg ("make %d calls", CALLS);
+
+  /* The server exits instead of replying to this one. */
+  m.w[0] = 0;
+  CHECK (ipc_call (server, &m) == -1, "call that ends the server");
+  CHECK (wait (server) == 0x42, "wait for server");
+  CHECK (ipc_call (server, &m) == -1, "call exited server");
+}
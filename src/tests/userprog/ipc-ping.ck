@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ipc-ping) begin
+(ipc-ping) fork
+(ipc-ping) make 100 calls
+(ipc-ping) call that ends the server
+ipc-ping: exit(66)
+(ipc-ping) wait for server
+(ipc-ping) call exited server
+(ipc-ping) end
+ipc-ping: exit(0)
+EOF
+pass;
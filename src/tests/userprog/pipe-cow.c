@@ -0,0 +1,43 @@
+/* Forks after filling a static buffer, then has the parent
+   write the buffer into a pipe, more than the pipe can hold at
+   once, while the child reads into the same buffer.  The two
+   buffers may share a copy-on-write frame, which must not stay
+   pinned while either side waits for the other. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Buffer, several pages long. */
+static char buf[4 * 4096];
+
+void
+test_main (void)
+{
+  size_t i;
+  pid_t child;
+  int fds[2];
+
+  for (i = 0; i < sizeof buf; i++)
+    buf[i] = i % 251;
+  CHECK (pipe (fds), "pipe");
+  CHECK ((child = fork ()) != PID_ERROR, "fork");
+  if (child == 0)
+    {
+      size_t total = 0;
+      int cnt;
+
+      close (fds[1]);
+      while ((cnt = read (fds[0], buf, sizeof buf)) > 0)
+        for (i = 0; i < (size_t) cnt; i++, total++)
+          if (buf[i] != (char) (total % 251))
+            exit (1);
+      exit (total == sizeof buf ? 0x42 : 2);
+    }
+
+  close (fds[0]);
+  CHECK (write (fds[1], buf, sizeof buf) == (int) sizeof buf,
+         "write buffer to pipe");
+  close (fds[1]);
+  CHECK (wait (child) == 0x42, "wait for child");
+}
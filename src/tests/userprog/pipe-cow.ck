@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-cow) begin
+(pipe-cow) pipe
+(pipe-cow) fork
+(pipe-cow) write buffer to pipe
+pipe-cow: exit(66)
+(pipe-cow) wait for child
+(pipe-cow) end
+pipe-cow: exit(0)
+EOF
+pass;
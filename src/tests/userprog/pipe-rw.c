@@ -0,0 +1,61 @@
+/* Streams many copies of a sample text from a forked child to
+   its parent through a pipe, more than the pipe can hold at
+   once, with the child writing through a dup() of the write
+   end.  Then checks end of file and writing with no reader. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Number of copies of the sample to send. */
+#define ROUNDS 64
+
+void
+test_main (void)
+{
+  size_t size = sizeof sample - 1;
+  size_t total = 0;
+  char buf[100];
+  pid_t child;
+  int fds[2];
+  int cnt;
+
+  CHECK (pipe (fds), "pipe");
+  CHECK (fds[0] > 1 && fds[1] > 1 && fds[0] != fds[1],
+         "pipe descriptors are distinct and not the console's");
+  CHECK ((child = fork ()) != PID_ERROR, "fork");
+  if (child == 0)
+    {
+      int out = dup (fds[1]);
+      int i;
+
+      close (fds[0]);
+      close (fds[1]);
+      for (i = 0; i < ROUNDS; i++)
+        if (write (out, sample, size) != (int) size)
+          exit (1);
+      exit (0x42);
+    }
+
+  /* The child's exit message comes before end of file, because
+     its write end stays open until it exits. */
+  close (fds[1]);
+  while ((cnt = read (fds[0], buf, sizeof buf)) > 0)
+    {
+      int i;
+
+      for (i = 0; i < cnt; i++, total++)
+        if (buf[i] != sample[total % size])
+          fail ("byte %zu read as %02hhx", total, buf[i]);
+    }
+  CHECK (cnt == 0 && total == ROUNDS * size, "read to end of file");
+  CHECK (wait (child) == 0x42, "wait for child");
+  CHECK (write (fds[0], sample, 1) == -1, "write to read end");
+  close (fds[0]);
+
+  CHECK (pipe (fds), "pipe");
+  close (fds[0]);
+  CHECK (write (fds[1], sample, size) == -1, "write with no reader");
+  close (fds[1]);
+}
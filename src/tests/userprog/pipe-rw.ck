@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-rw) begin
+(pipe-rw) pipe
+(pipe-rw) pipe descriptors are distinct and not the console's
+(pipe-rw) fork
+pipe-rw: exit(66)
+(pipe-rw) read to end of file
+(pipe-rw) wait for child
+(pipe-rw) write to read end
+(pipe-rw) pipe
+(pipe-rw) write with no reader
+(pipe-rw) end
+pipe-rw: exit(0)
+EOF
+pass;
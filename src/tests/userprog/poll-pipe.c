@@ -0,0 +1,65 @@
+/* Polls the ends of a pipe, a forked child that writes to the
+   pipe and exits, and some other descriptors, checking the
+   events reported each time. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  struct pollfd pfd[2];
+  pid_t child;
+  int fds[2];
+  int ready;
+  char c;
+
+  CHECK (pipe (fds), "pipe");
+  pfd[0].fd = fds[0];
+  pfd[0].events = POLLIN;
+  pfd[1].fd = fds[1];
+  pfd[1].events = POLLIN | POLLOUT;
+  CHECK (poll (pfd, 2, 0) == 1
+         && pfd[0].revents == 0 && pfd[1].revents == POLLOUT,
+         "poll empty pipe");
+  CHECK (poll (pfd, 1, 50) == 0 && pfd[0].revents == 0,
+         "poll empty pipe for 50 ms");
+
+  child = fork ();
+  if (child == 0)
+    {
+      write (fds[1], "x", 1);
+      exit (0x42);
+    }
+  if (child == PID_ERROR)
+    fail ("fork failed");
+
+  /* Print nothing until the child has exited, so that its exit
+     message comes first. */
+  pfd[0].fd = child;
+  pfd[0].events = POLLCHILD;
+  ready = poll (pfd, 1, -1);
+  CHECK (ready == 1 && pfd[0].revents == POLLIN, "poll for child exit");
+  CHECK (wait (child) == 0x42, "wait for child");
+  CHECK (poll (pfd, 1, 0) == 1 && pfd[0].revents == POLLNVAL,
+         "poll waited-for child");
+
+  pfd[0].fd = fds[0];
+  pfd[0].events = POLLIN;
+  CHECK (poll (pfd, 1, -1) == 1 && pfd[0].revents == POLLIN,
+         "poll pipe with data");
+  CHECK (read (fds[0], &c, 1) == 1 && c == 'x', "read pipe");
+  close (fds[1]);
+  CHECK (poll (pfd, 1, -1) == 1 && pfd[0].revents == POLLHUP,
+         "poll pipe with no writer");
+  close (fds[0]);
+
+  pfd[0].fd = fds[0];
+  pfd[1].fd = STDOUT_FILENO;
+  pfd[1].events = POLLOUT;
+  CHECK (poll (pfd, 2, -1) == 2
+         && pfd[0].revents == POLLNVAL && pfd[1].revents == POLLOUT,
+         "poll closed descriptor and console");
+}
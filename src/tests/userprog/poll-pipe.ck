@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(poll-pipe) begin
+(poll-pipe) pipe
+(poll-pipe) poll empty pipe
+(poll-pipe) poll empty pipe for 50 ms
+poll-pipe: exit(66)
+(poll-pipe) poll for child exit
+(poll-pipe) wait for child
+(poll-pipe) poll waited-for child
+(poll-pipe) poll pipe with data
+(poll-pipe) read pipe
+(poll-pipe) poll pipe with no writer
+(poll-pipe) poll closed descriptor and console
+(poll-pipe) end
+poll-pipe: exit(0)
+EOF
+pass;
@@ -0,0 +1,33 @@
+/* Writes the two halves of a file in reverse order with pwrite
+   and reads it back with pread, checking that neither moves the
+   file position. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  size_t size = sizeof sample - 1;
+  size_t half = size / 2;
+  char buf[sizeof sample];
+  int fd;
+
+  CHECK (create ("pos.dat", size), "create \"pos.dat\"");
+  CHECK ((fd = open ("pos.dat")) > 1, "open \"pos.dat\"");
+  seek (fd, 5);
+  CHECK (pwrite (fd, sample + half, size - half, half)
+         == (int) (size - half), "pwrite second half");
+  CHECK (pwrite (fd, sample, half, 0) == (int) half, "pwrite first half");
+  CHECK (pread (fd, buf, size, 0) == (int) size, "pread \"pos.dat\"");
+  CHECK (!memcmp (buf, sample, size),
+         "compare read data against written data");
+  CHECK (pread (fd, buf, size, size) == 0, "pread at end of file");
+  CHECK (tell (fd) == 5, "tell \"pos.dat\" unchanged");
+  CHECK (pread (STDIN_FILENO, buf, 1, 0) == -1, "pread from console");
+  close (fd);
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) create "pos.dat"
+(pread-pwrite) open "pos.dat"
+(pread-pwrite) pwrite second half
+(pread-pwrite) pwrite first half
+(pread-pwrite) pread "pos.dat"
+(pread-pwrite) compare read data against written data
+(pread-pwrite) pread at end of file
+(pread-pwrite) tell "pos.dat" unchanged
+(pread-pwrite) pread from console
+(pread-pwrite) end
+pread-pwrite: exit(0)
+EOF
+pass;
@@ -0,0 +1,45 @@
+/* Writes a file from three buffers with writev, then reads it
+   back into buffers split at different places with readv. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  size_t size = sizeof sample - 1;
+  char a[16], b[100], c[sizeof sample];
+  struct iovec out[3], in[3];
+  int fd;
+
+  out[0].iov_base = sample;
+  out[0].iov_len = 10;
+  out[1].iov_base = sample + 10;
+  out[1].iov_len = 0;
+  out[2].iov_base = sample + 10;
+  out[2].iov_len = size - 10;
+
+  in[0].iov_base = a;
+  in[0].iov_len = sizeof a;
+  in[1].iov_base = b;
+  in[1].iov_len = sizeof b;
+  in[2].iov_base = c;
+  in[2].iov_len = size - sizeof a - sizeof b;
+
+  CHECK (create ("iov.dat", size), "create \"iov.dat\"");
+  CHECK ((fd = open ("iov.dat")) > 1, "open \"iov.dat\"");
+  CHECK (writev (fd, out, 3) == (int) size, "writev \"iov.dat\"");
+  CHECK (tell (fd) == size, "tell \"iov.dat\" after writev");
+  seek (fd, 0);
+  CHECK (readv (fd, in, 3) == (int) size, "readv \"iov.dat\"");
+  CHECK (!memcmp (a, sample, sizeof a)
+         && !memcmp (b, sample + sizeof a, sizeof b)
+         && !memcmp (c, sample + sizeof a + sizeof b,
+                     size - sizeof a - sizeof b),
+         "compare read data against written data");
+  CHECK (readv (fd, in, 0) == -1, "readv with no buffers");
+  close (fd);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-writev) begin
+(readv-writev) create "iov.dat"
+(readv-writev) open "iov.dat"
+(readv-writev) writev "iov.dat"
+(readv-writev) tell "iov.dat" after writev
+(readv-writev) readv "iov.dat"
+(readv-writev) compare read data against written data
+(readv-writev) readv with no buffers
+(readv-writev) end
+readv-writev: exit(0)
+EOF
+pass;
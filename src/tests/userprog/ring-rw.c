@@ -0,0 +1,73 @@
+/* Opens a file through a submission ring, then writes it, seeks
+   back to the start, reads it back, and closes it, all in a
+   single batch, and verifies that the requests ran in order. */
+
+#include <ring.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define RING ((struct ring *) 0x10000000)
+
+/* Queues a request in RING. */
+static void
+queue (int op, int fd, void *buf, unsigned size, unsigned user_data)
+{
+  struct ring_sqe *sqe = ring_next_sqe (RING);
+
+  if (sqe == NULL)
+    fail ("submission ring full");
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->buf = buf;
+  sqe->size = size;
+  sqe->user_data = user_data;
+  ring_push (RING);
+}
+
+/* Consumes the next completion in RING, which must be for
+   request USER_DATA, and returns its result. */
+static int
+reap (unsigned user_data)
+{
+  struct ring_cqe *cqe = ring_peek_cqe (RING);
+  int result;
+
+  if (cqe == NULL)
+    fail ("no completion for request %u", user_data);
+  if (cqe->user_data != user_data)
+    fail ("completion for request %u, expected %u",
+          cqe->user_data, user_data);
+  result = cqe->result;
+  ring_pop (RING);
+  return result;
+}
+
+void
+test_main (void)
+{
+  char buf[sizeof sample];
+  int fd;
+
+  CHECK (create ("ring.dat", sizeof sample - 1), "create \"ring.dat\"");
+  CHECK (ring_setup (RING), "set up ring");
+
+  queue (RING_OPEN, 0, "ring.dat", 0, 1);
+  CHECK (ring_enter (1, 1) == 1, "submit open");
+  CHECK ((fd = reap (1)) > 1, "open \"ring.dat\"");
+
+  queue (RING_WRITE, fd, sample, sizeof sample - 1, 2);
+  queue (RING_SEEK, fd, NULL, 0, 3);
+  queue (RING_READ, fd, buf, sizeof sample - 1, 4);
+  queue (RING_CLOSE, fd, NULL, 0, 5);
+  CHECK (ring_enter (4, 4) == 4, "submit write, seek, read, close");
+  CHECK (reap (2) == (int) sizeof sample - 1, "write \"ring.dat\"");
+  CHECK (reap (3) == 0, "seek \"ring.dat\" to 0");
+  CHECK (reap (4) == (int) sizeof sample - 1, "read \"ring.dat\"");
+  CHECK (reap (5) == 0, "close \"ring.dat\"");
+  CHECK (ring_peek_cqe (RING) == NULL, "completion ring empty");
+  CHECK (!memcmp (buf, sample, sizeof sample - 1),
+         "compare read data against written data");
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-rw) begin
+(ring-rw) create "ring.dat"
+(ring-rw) set up ring
+(ring-rw) submit open
+(ring-rw) open "ring.dat"
+(ring-rw) submit write, seek, read, close
+(ring-rw) write "ring.dat"
+(ring-rw) seek "ring.dat" to 0
+(ring-rw) read "ring.dat"
+(ring-rw) close "ring.dat"
+(ring-rw) completion ring empty
+(ring-rw) compare read data against written data
+(ring-rw) end
+ring-rw: exit(0)
+EOF
+pass;
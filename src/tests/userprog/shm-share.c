@@ -0,0 +1,69 @@
+/* Shares a three-page segment between a process and its forked
+   child, which also maps it a second time and changes it
+   through either mapping.  Then reads from a pipe straight into
+   the segment and checks that bad handles, bad addresses, and
+   bad unmaps are refused. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Segment size, just over two pages. */
+#define SIZE (2 * 4096 + 1)
+
+/* Where the segment is mapped. */
+static char *const shm = (char *) 0x10000000;
+static char *const alias = (char *) 0x10100000;
+
+void
+test_main (void)
+{
+  size_t size = sizeof sample - 1;
+  pid_t child;
+  int handle;
+  int fds[2];
+  int i;
+
+  CHECK ((handle = shm_create (SIZE)) != -1, "shm_create");
+  CHECK (shm_map (handle, shm) == shm, "shm_map");
+  for (i = 0; i < 3 * 4096; i++)
+    if (shm[i] != 0)
+      fail ("byte %d of new segment is %02hhx", i, shm[i]);
+  memcpy (shm, sample, size);
+
+  CHECK ((child = fork ()) != PID_ERROR, "fork");
+  if (child == 0)
+    {
+      if (memcmp (shm, sample, size))
+        exit (1);
+      if (shm_map (handle, alias) != alias)
+        exit (2);
+      for (i = 0; i < 3 * 4096; i++)
+        alias[i] = i % 251;
+      if (shm[4096] != alias[4096] || shm[SIZE] != alias[SIZE])
+        exit (3);
+      exit (0x42);
+    }
+  CHECK (wait (child) == 0x42, "wait for child");
+  for (i = 0; i < 3 * 4096; i++)
+    if (shm[i] != (char) (i % 251))
+      fail ("byte %d of segment is %02hhx", i, shm[i]);
+
+  CHECK (pipe (fds), "pipe");
+  CHECK (write (fds[1], sample, size) == (int) size, "write to pipe");
+  CHECK (read (fds[0], shm + 4096 - 10, size) == (int) size,
+         "read from pipe into segment");
+  CHECK (!memcmp (shm + 4096 - 10, sample, size), "compare data");
+  close (fds[0]);
+  close (fds[1]);
+
+  CHECK (shm_map (handle + 1, alias) == NULL, "map bad handle");
+  CHECK (shm_map (handle, alias + 1) == NULL, "map misaligned address");
+  CHECK (shm_map (handle, shm + 4096) == NULL, "map over segment");
+  CHECK (shm_unmap (shm), "shm_unmap");
+  CHECK (!shm_unmap (shm), "unmap again");
+  CHECK (shm_map (handle, shm) == shm, "map again");
+  CHECK (!memcmp (shm + 4096 - 10, sample, size), "compare data");
+}
@@ -0,0 +1,26 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(shm-share) begin
+(shm-share) shm_create
+(shm-share) shm_map
+(shm-share) fork
+shm-share: exit(66)
+(shm-share) wait for child
+(shm-share) pipe
+(shm-share) write to pipe
+(shm-share) read from pipe into segment
+(shm-share) compare data
+(shm-share) map bad handle
+(shm-share) map misaligned address
+(shm-share) map over segment
+(shm-share) shm_unmap
+(shm-share) unmap again
+(shm-share) map again
+(shm-share) compare data
+(shm-share) end
+shm-share: exit(0)
+EOF
+pass;
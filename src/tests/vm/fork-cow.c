@@ -0,0 +1,43 @@
+/* Forks a child that shares a large array with its parent
+   copy-on-write.  The child checks that it sees the parent's
+   data and then overwrites half of it, and the parent checks
+   that its own copy is unaffected. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (128 * 1024)
+
+static char buf[SIZE];
+
+void
+test_main (void)
+{
+  pid_t child;
+  int status;
+  size_t i;
+
+  memset (buf, 'p', SIZE);
+  CHECK ((child = fork ()) != PID_ERROR, "fork");
+  if (child == 0)
+    {
+      for (i = 0; i < SIZE; i++)
+        if (buf[i] != 'p')
+          fail ("child sees byte %zu as %02hhx", i, buf[i]);
+      memset (buf, 'c', SIZE / 2);
+      for (i = 0; i < SIZE / 2; i++)
+        if (buf[i] != 'c')
+          fail ("child's write to byte %zu was lost", i);
+      exit (0x42);
+    }
+
+  /* Wait before printing, so that the child's exit message comes
+     first. */
+  status = wait (child);
+  CHECK (status == 0x42, "wait for child");
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != 'p')
+      fail ("parent's byte %zu changed to %02hhx", i, buf[i]);
+}
@@ -0,0 +1,43 @@
+/* Touches pages of a zero-initialized array, first reading and
+   then writing them, and checks that the memstat system call
+   accounts for the resulting faults and resident pages. */
+
+#include <memstat.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_CNT 32
+
+/* One extra page, so that PAGE_CNT whole pages fit. */
+static char buf[(PAGE_CNT + 1) * 4096];
+
+void
+test_main (void)
+{
+  struct memstat before, after_read, after_write;
+  char *start = (char *) (((uintptr_t) buf + 4095) & ~4095);
+  char *end = start + PAGE_CNT * 4096;
+  volatile char *p;
+  int sum = 0;
+
+  CHECK (memstat (&before), "memstat before");
+
+  /* Reading maps the shared zero page, which is not resident. */
+  for (p = start; p < end; p += 4096)
+    sum += *p;
+  CHECK (memstat (&after_read), "memstat after reading");
+  CHECK (sum == 0, "array is zeroed");
+  CHECK (after_read.minor_faults - before.minor_faults >= PAGE_CNT,
+         "reads caused at least %d minor faults", PAGE_CNT);
+
+  /* Writing gives each page a frame. */
+  for (p = start; p < end; p += 4096)
+    *p = 1;
+  CHECK (memstat (&after_write), "memstat after writing");
+  CHECK (after_write.minor_faults - after_read.minor_faults >= PAGE_CNT,
+         "writes caused at least %d minor faults", PAGE_CNT);
+  CHECK (after_write.resident - after_read.resident >= PAGE_CNT,
+         "at least %d more pages resident", PAGE_CNT);
+}
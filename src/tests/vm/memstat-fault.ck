@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(memstat-fault) begin
+(memstat-fault) memstat before
+(memstat-fault) memstat after reading
+(memstat-fault) array is zeroed
+(memstat-fault) reads caused at least 32 minor faults
+(memstat-fault) memstat after writing
+(memstat-fault) writes caused at least 32 minor faults
+(memstat-fault) at least 32 more pages resident
+(memstat-fault) end
+EOF
+pass;
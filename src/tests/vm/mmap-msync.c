@@ -0,0 +1,38 @@
+/* Writes to a file through a mapping, flushes the mapping with
+   msync, and reads the data in the file back using the read
+   system call to verify, before the file is unmapped.  Then
+   verifies that an unmodified mapping can be flushed too. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+
+void
+test_main (void)
+{
+  int handle;
+  mapid_t map;
+  char buf[1024];
+
+  /* Write file via mmap. */
+  CHECK (create ("sample.txt", strlen (sample)), "create \"sample.txt\"");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (handle, ACTUAL)) != MAP_FAILED, "mmap \"sample.txt\"");
+  memcpy (ACTUAL, sample, strlen (sample));
+  CHECK (msync (map), "msync \"sample.txt\"");
+
+  /* Read back via read() while still mapped. */
+  CHECK (read (handle, buf, strlen (sample)) == (int) strlen (sample),
+         "read \"sample.txt\"");
+  CHECK (!memcmp (buf, sample, strlen (sample)),
+         "compare read data against written data");
+
+  /* Nothing left to write. */
+  CHECK (msync (map), "msync \"sample.txt\" again");
+  munmap (map);
+  close (handle);
+}
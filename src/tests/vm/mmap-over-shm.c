@@ -0,0 +1,21 @@
+/* Verifies that mapping a file over a shared memory segment is
+   disallowed, and that the segment is unharmed. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char *shm = (char *) 0x10000000;
+  int handle, fd;
+
+  CHECK ((handle = shm_create (4096)) != -1, "shm_create");
+  CHECK (shm_map (handle, shm) == shm, "shm_map");
+  shm[0] = 'x';
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (fd, shm) == MAP_FAILED,
+         "try to mmap over shared memory segment");
+  CHECK (shm[0] == 'x', "segment unchanged");
+}
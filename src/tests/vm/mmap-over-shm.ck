@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-over-shm) begin
+(mmap-over-shm) shm_create
+(mmap-over-shm) shm_map
+(mmap-over-shm) open "sample.txt"
+(mmap-over-shm) try to mmap over shared memory segment
+(mmap-over-shm) segment unchanged
+(mmap-over-shm) end
+EOF
+pass;
@@ -0,0 +1,44 @@
+/* Forks a child that shares a buffer with its parent
+   copy-on-write and reads a file into it with the read system
+   call, straddling a page boundary.  The read goes directly
+   into the child's pages, so it must give the child private
+   copies of them first: the parent checks that its own copy is
+   unaffected. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (3 * 4096)
+
+static char buf[SIZE] __attribute__ ((aligned (4096)));
+
+void
+test_main (void)
+{
+  size_t size = sizeof sample - 1;
+  char *target = buf + 4096 - size / 2;
+  pid_t child;
+  size_t i;
+  int fd;
+
+  memset (buf, 'p', SIZE);
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((child = fork ()) != PID_ERROR, "fork");
+  if (child == 0)
+    {
+      if (read (fd, target, size) != (int) size)
+        fail ("child's read returned wrong count");
+      if (memcmp (target, sample, size))
+        fail ("child read wrong data");
+      exit (0x42);
+    }
+
+  CHECK (wait (child) == 0x42, "wait for child");
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != 'p')
+      fail ("parent's byte %zu changed to %02hhx", i, buf[i]);
+  close (fd);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(read-cow) begin
+(read-cow) open "sample.txt"
+(read-cow) fork
+read-cow: exit(66)
+(read-cow) wait for child
+(read-cow) end
+read-cow: exit(0)
+EOF
+pass;
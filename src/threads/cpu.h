@@ -0,0 +1,63 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Control register 4 (CR4) flags.
+   See [IA32-v3a] 2.5 "Control Registers". */
+#define CR4_PSE 0x00000010      /* Page Size Extensions (4 MB pages). */
+#define CR4_PGE 0x00000080      /* Page Global Enable. */
+
+/* Feature flags reported in EDX by CPUID function 1.
+   See [IA32-v2a] "CPUID". */
+#define CPUID_PSE 0x00000008    /* Page Size Extensions. */
+#define CPUID_SEP 0x00000800    /* SYSENTER and SYSEXIT. */
+#define CPUID_PGE 0x00002000    /* Page Global Enable. */
+
+/* Model-specific registers that configure SYSENTER.
+   See [IA32-v3a] 4.8.7 "Fast System Calls". */
+#define MSR_SYSENTER_CS 0x174   /* Kernel code selector. */
+#define MSR_SYSENTER_ESP 0x175  /* Kernel stack pointer. */
+#define MSR_SYSENTER_EIP 0x176  /* Kernel entry point. */
+
+/* Returns true if the CPU supports all of the CPUID function 1
+   EDX feature flags in FEATURES, false otherwise. */
+static inline bool
+cpu_has_features (uint32_t features)
+{
+  /* See [IA32-v2a] "CPUID". */
+  uint32_t eax = 1, ebx, ecx, edx;
+  asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+  return (edx & features) == features;
+}
+
+/* Returns the contents of control register 4. */
+static inline uint32_t
+read_cr4 (void)
+{
+  /* See [IA32-v2a] "MOV--Move to/from Control Registers". */
+  uint32_t cr4;
+  asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+  return cr4;
+}
+
+/* Stores CR4 into control register 4. */
+static inline void
+write_cr4 (uint32_t cr4)
+{
+  /* See [IA32-v2a] "MOV--Move to/from Control Registers". */
+  asm volatile ("movl %0, %%cr4" : : "r" (cr4) : "memory");
+}
+
+/* Stores VALUE into model-specific register MSR. */
+static inline void
+write_msr (uint32_t msr, uint64_t value)
+{
+  /* See [IA32-v2b] "WRMSR--Write to Model Specific Register". */
+  asm volatile ("wrmsr"
+                : : "c" (msr), "a" ((uint32_t) value),
+                    "d" ((uint32_t) (value >> 32)));
+}
+
+#endif /* threads/cpu.h */
@@ -15,8 +15,10 @@
 #include "devices/timer.h"
 #include "devices/vga.h"
 #include "devices/rtc.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/kmap.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
@@ -37,6 +39,12 @@
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/readahead.h"
+#include "vm/swap.h"
+#endif
 
 /* Page directory with kernel mappings only. */
 uint32_t *init_page_dir;
@@ -57,6 +65,17 @@ static const char *swap_bdev_name;
 /* -ul: Maximum number of pages to put into palloc's user pool. */
 static size_t user_page_limit = SIZE_MAX;
 
+#ifdef VM
+/* -vm-low, -vm-high: Free frame watermarks for the page-out
+   daemon, or 0 for the defaults. */
+static size_t vm_low_water;
+static size_t vm_high_water;
+
+/* -zswap: Size of the compressed swap cache in pages, or 0 to
+   disable it. */
+static size_t zswap_pages;
+#endif
+
 static void bss_init (void);
 static void paging_init (void);
 
@@ -91,13 +110,24 @@ main (void)
   console_init ();  
 
   /* Greet user. */
-  printf ("Pintos booting with %'"PRIu32" kB RAM...\n",
-          init_ram_pages * PGSIZE / 1024);
+  if (init_high_pages > 0)
+    printf ("Pintos booting with %'"PRIu32" kB RAM "
+            "(%'"PRIu32" kB high memory)...\n",
+            (init_ram_pages + init_high_pages) * (PGSIZE / 1024),
+            init_high_pages * (PGSIZE / 1024));
+  else
+    printf ("Pintos booting with %'"PRIu32" kB RAM...\n",
+            init_ram_pages * PGSIZE / 1024);
 
   /* Initialize memory system. */
   palloc_init (user_page_limit);
   malloc_init ();
   paging_init ();
+  kmap_init ();
+#ifdef VM
+  frame_init ();
+  page_init ();
+#endif
 
   /* Segmentation. */
 #ifdef USERPROG
@@ -127,6 +157,14 @@ main (void)
   filesys_init (format_filesys);
 #endif
 
+#ifdef VM
+  /* Initialize swap space and start paging out and reading
+     ahead. */
+  swap_init (zswap_pages);
+  frame_start_pageout (vm_low_water, vm_high_water);
+  readahead_init ();
+#endif
+
   printf ("Boot complete.\n");
   
   /* Run actions specified on kernel command line. */
@@ -153,13 +191,31 @@ bss_init (void)
 /* Populates the base page directory and page table with the
    kernel virtual mapping, and then sets up the CPU to use the
    new page directory.  Points init_page_dir to the page
-   directory it creates. */
+   directory it creates.
+
+   If the CPU supports page size extensions, then each 4 MB
+   region of physical memory that lies entirely within RAM is
+   mapped with a single 4 MB page, which saves a page table and
+   lets one TLB entry cover the whole region.  The region that
+   contains the kernel text still uses 4 kB pages, so that the
+   text can be write-protected without also write-protecting the
+   data that shares its 4 MB region.
+
+   All of these mappings are marked global, since they are the
+   same in every page directory. */
 static void
 paging_init (void)
 {
   uint32_t *pd, *pt;
   size_t page;
   extern char _start, _end_kernel_text;
+  bool pse = cpu_has_features (CPUID_PSE);
+
+  /* Large pages must be enabled before CR3 is loaded with a page
+     directory that uses them.  See [IA32-v3a] 3.6.1 "Paging
+     Options". */
+  if (pse)
+    write_cr4 (read_cr4 () | CR4_PSE);
 
   pd = init_page_dir = palloc_get_page (PAL_ASSERT | PAL_ZERO);
   pt = NULL;
@@ -171,6 +227,15 @@ paging_init (void)
       size_t pte_idx = pt_no (vaddr);
       bool in_kernel_text = &_start <= vaddr && vaddr < &_end_kernel_text;
 
+      if (pse && pte_idx == 0 && page + PTSPAN / PGSIZE <= init_ram_pages
+          && (vaddr + PTSPAN <= &_start || vaddr >= &_end_kernel_text))
+        {
+          /* Map the whole 4 MB region at once. */
+          pd[pde_idx] = pde_create_large (vaddr, true);
+          page += PTSPAN / PGSIZE - 1;
+          continue;
+        }
+
       if (pd[pde_idx] == 0)
         {
           pt = palloc_get_page (PAL_ASSERT | PAL_ZERO);
@@ -186,6 +251,14 @@ paging_init (void)
      to/from Control Registers" and [IA32-v3a] 3.7.5 "Base Address
      of the Page Directory". */
   asm volatile ("movl %0, %%cr3" : : "r" (vtop (init_page_dir)));
+
+  /* Honor the global bit in kernel PTEs and large PDEs from now
+     on.  This is done only after CR3 has been loaded, so that
+     none of the loader's temporary mappings can linger in the
+     TLB as global entries.  See [IA32-v3a] 3.12 "Translation
+     Lookaside Buffers (TLBs)". */
+  if (cpu_has_features (CPUID_PGE))
+    write_cr4 (read_cr4 () | CR4_PGE);
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -259,6 +332,14 @@ parse_options (char **argv)
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-vm-low"))
+        vm_low_water = atoi (value);
+      else if (!strcmp (name, "-vm-high"))
+        vm_high_water = atoi (value);
+      else if (!strcmp (name, "-zswap"))
+        zswap_pages = atoi (value);
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -381,6 +462,11 @@ usage (void)
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+          "  -vm-low=COUNT      Start paging out below COUNT free pages.\n"
+          "  -vm-high=COUNT     Stop paging out at COUNT free pages.\n"
+          "  -zswap=COUNT       Compress swap into COUNT pages of RAM first.\n"
 #endif
           );
   shutdown_power_off ();
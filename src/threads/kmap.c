@@ -0,0 +1,94 @@
+#include "threads/kmap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <stdbool.h>
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Temporary kernel mappings.
+
+   The kernel maps only the first LOADER_MAX_RAM_PAGES pages of
+   physical memory (see paging_init()).  Pages beyond that, in
+   the high pool, hold only user pages, which user processes
+   reach through their own page tables.  When the kernel itself
+   has to read or write one, to load it from a file or write it
+   to swap, say, it maps the page into a slot of the kmap window
+   with kmap() and unmaps it afterward with kunmap().
+
+   The window is a single page table, installed in init_page_dir
+   before any other page directory is created, so that every page
+   directory shares it.  When all of its slots are in use, kmap()
+   waits for one to be freed, so callers should not keep pages
+   mapped for long, nor hold locks that kunmap() callers might
+   need while waiting. */
+
+/* Page table for the kmap window. */
+static uint32_t *kmap_pt;
+
+/* Slots in use, protected by kmap_lock.  kmap_cond is signaled
+   when a slot is freed. */
+static struct bitmap *used_slots;
+static struct lock kmap_lock;
+static struct condition kmap_cond;
+
+/* Sets up the kmap window.  Must be called after paging_init()
+   and before any page directory other than init_page_dir is
+   created. */
+void
+kmap_init (void)
+{
+  ASSERT (pg_ofs (KMAP_BASE) == 0 && pt_no (KMAP_BASE) == 0);
+  ASSERT (init_page_dir[pd_no (KMAP_BASE)] == 0);
+
+  kmap_pt = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+  init_page_dir[pd_no (KMAP_BASE)] = pde_create (kmap_pt);
+  used_slots = bitmap_create (KMAP_PAGES);
+  if (used_slots == NULL)
+    PANIC ("kmap: bitmap creation failed");
+  lock_init (&kmap_lock);
+  cond_init (&kmap_cond);
+}
+
+/* Maps the page at physical address PADDR into the kernel's
+   address space, writable, and returns its kernel virtual
+   address, waiting for a free slot if necessary.  Must be
+   undone with kunmap(). */
+void *
+kmap (uintptr_t paddr)
+{
+  size_t slot;
+
+  ASSERT (paddr % PGSIZE == 0);
+
+  lock_acquire (&kmap_lock);
+  while ((slot = bitmap_scan_and_flip (used_slots, 0, 1, false))
+         == BITMAP_ERROR)
+    cond_wait (&kmap_cond, &kmap_lock);
+  lock_release (&kmap_lock);
+
+  kmap_pt[slot] = paddr | PTE_G | PTE_P | PTE_W;
+  return KMAP_BASE + slot * PGSIZE;
+}
+
+/* Unmaps KADDR, which kmap() returned. */
+void
+kunmap (const void *kaddr)
+{
+  size_t slot = pg_no (kaddr) - pg_no (KMAP_BASE);
+
+  ASSERT (pg_ofs (kaddr) == 0);
+  ASSERT (slot < KMAP_PAGES);
+
+  /* The entry is global, so reloading CR3 would not flush it. */
+  kmap_pt[slot] = 0;
+  asm volatile ("invlpg (%0)" : : "r" (kaddr) : "memory");
+
+  lock_acquire (&kmap_lock);
+  ASSERT (bitmap_test (used_slots, slot));
+  bitmap_reset (used_slots, slot);
+  cond_signal (&kmap_cond, &kmap_lock);
+  lock_release (&kmap_lock);
+}
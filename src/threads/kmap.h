@@ -0,0 +1,20 @@
+#ifndef THREADS_KMAP_H
+#define THREADS_KMAP_H
+
+#include <stdint.h>
+
+/* Temporary kernel mappings of physical pages, for getting at
+   high memory, which is not mapped into the kernel's address
+   space otherwise. */
+
+/* Base of the kmap window: the top 4 MB of virtual memory. */
+#define KMAP_BASE ((uint8_t *) 0xffc00000)
+
+/* Number of pages that may be mapped at once. */
+#define KMAP_PAGES 1024
+
+void kmap_init (void);
+void *kmap (uintptr_t paddr);
+void kunmap (const void *kaddr);
+
+#endif /* threads/kmap.h */
@@ -12,6 +12,12 @@
    Must be aligned on a 4 MB boundary. */
 #define LOADER_PHYS_BASE 0xc0000000     /* 3 GB. */
 
+/* Most physical memory mapped at LOADER_PHYS_BASE, in 4 kB pages.
+   Memory beyond this is "high memory", which only holds user
+   pages (see threads/kmap.c).  This leaves the top of the kernel's
+   address space free for temporary mappings. */
+#define LOADER_MAX_RAM_PAGES 0x30000    /* 768 MB. */
+
 /* Important loader physical addresses. */
 #define LOADER_SIG (LOADER_END - LOADER_SIG_LEN)   /* 0xaa55 BIOS signature. */
 #define LOADER_PARTS (LOADER_SIG - LOADER_PARTS_LEN)     /* Partition table. */
@@ -33,8 +39,10 @@
 #ifndef __ASSEMBLER__
 #include <stdint.h>
 
-/* Amount of physical memory, in 4 kB pages. */
+/* Amount of physical memory mapped into the kernel's address
+   space, and of high memory beyond it, in 4 kB pages. */
 extern uint32_t init_ram_pages;
+extern uint32_t init_high_pages;
 #endif
 
 #endif /* threads/loader.h */
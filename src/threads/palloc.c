@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -23,25 +24,39 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   RAM beyond what the kernel maps into its address space, if
+   any, forms a third pool, the high pool.  The kernel can only
+   get at a page in the high pool by mapping it temporarily (see
+   kmap.c), so the pool only serves as extra user memory, and it
+   hands out physical addresses rather than kernel virtual ones.
+
+   The pools' bitmaps live at the start of free memory, ahead of
+   the kernel pool, so that setting them up only touches memory
+   that the loader's temporary page tables map. */
 
 /* A memory pool. */
 struct pool
   {
     struct lock lock;                   /* Mutual exclusion. */
     struct bitmap *used_map;            /* Bitmap of free pages. */
+    size_t free_cnt;                    /* Number of free pages. */
     uint8_t *base;                      /* Base of pool. */
   };
 
-/* Two pools: one for kernel data, one for user pages. */
-static struct pool kernel_pool, user_pool;
+/* Three pools: one for kernel data, one for user pages, and one
+   for user pages in high memory. */
+static struct pool kernel_pool, user_pool, high_pool;
 
-static void init_pool (struct pool *, void *base, size_t page_cnt,
-                       const char *name);
+static void init_pool (struct pool *, void *bm, size_t bm_size,
+                       void *base, size_t page_cnt, const char *name);
+static size_t take_pages (struct pool *, size_t page_cnt);
+static void return_pages (struct pool *, size_t page_idx, size_t page_cnt);
 static bool page_from_pool (const struct pool *, void *page);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
-   pages are put into the user pool. */
+   pages are put into the user and high pools together. */
 void
 palloc_init (size_t user_page_limit)
 {
@@ -50,15 +65,37 @@ palloc_init (size_t user_page_limit)
   uint8_t *free_end = ptov (init_ram_pages * PGSIZE);
   size_t free_pages = (free_end - free_start) / PGSIZE;
   size_t user_pages = free_pages / 2;
-  size_t kernel_pages;
+  size_t high_pages = init_high_pages;
+  size_t kernel_pages, kernel_bm_size, user_bm_size, high_bm_size;
+  size_t bm_pages;
+  uint8_t *bm;
+
   if (user_pages > user_page_limit)
     user_pages = user_page_limit;
+  if (high_pages > user_page_limit - user_pages)
+    high_pages = user_page_limit - user_pages;
   kernel_pages = free_pages - user_pages;
 
-  /* Give half of memory to kernel, half to user. */
-  init_pool (&kernel_pool, free_start, kernel_pages, "kernel pool");
-  init_pool (&user_pool, free_start + kernel_pages * PGSIZE,
-             user_pages, "user pool");
+  /* Carve the bitmaps out of the kernel pool. */
+  kernel_bm_size = bitmap_buf_size (kernel_pages);
+  user_bm_size = bitmap_buf_size (user_pages);
+  high_bm_size = high_pages > 0 ? bitmap_buf_size (high_pages) : 0;
+  bm_pages = DIV_ROUND_UP (kernel_bm_size + user_bm_size + high_bm_size,
+                           PGSIZE);
+  if (bm_pages >= kernel_pages)
+    PANIC ("Not enough memory in kernel pool for bitmaps.");
+  bm = free_start;
+
+  /* Give half of memory to kernel, half to user, and all of high
+     memory to user. */
+  init_pool (&kernel_pool, bm, kernel_bm_size,
+             free_start + bm_pages * PGSIZE, kernel_pages - bm_pages,
+             "kernel pool");
+  init_pool (&user_pool, bm + kernel_bm_size, user_bm_size,
+             free_start + kernel_pages * PGSIZE, user_pages, "user pool");
+  if (high_pages > 0)
+    init_pool (&high_pool, bm + kernel_bm_size + user_bm_size, high_bm_size,
+               (void *) (init_ram_pages * PGSIZE), high_pages, "high pool");
 }
 
 /* Obtains and returns a group of PAGE_CNT contiguous free pages.
@@ -77,10 +114,7 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
-
+  page_idx = take_pages (pool, page_cnt);
   if (page_idx != BITMAP_ERROR)
     pages = pool->base + PGSIZE * page_idx;
   else
@@ -137,8 +171,7 @@ palloc_free_multiple (void *pages, size_t page_cnt)
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
-  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  return_pages (pool, page_idx, page_cnt);
 }
 
 /* Frees the page at PAGE. */
@@ -148,25 +181,110 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
-/* Initializes pool P as starting at START and ending at END,
-   naming it NAME for debugging purposes. */
-static void
-init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
+/* Obtains a free page of high memory and returns its physical
+   address, or 0 if none is free.  The page is not mapped into the
+   kernel's address space, so it is only good for user pages. */
+uintptr_t
+palloc_get_high_page (void)
+{
+  size_t page_idx;
+
+  if (high_pool.used_map == NULL)
+    return 0;
+  page_idx = take_pages (&high_pool, 1);
+  if (page_idx == BITMAP_ERROR)
+    return 0;
+  return (uintptr_t) high_pool.base + page_idx * PGSIZE;
+}
+
+/* Frees the high memory page at physical address PADDR. */
+void
+palloc_free_high_page (uintptr_t paddr)
+{
+  ASSERT (paddr % PGSIZE == 0);
+  ASSERT (page_from_pool (&high_pool, (void *) paddr));
+
+  return_pages (&high_pool, pg_no ((void *) paddr) - pg_no (high_pool.base),
+                1);
+}
+
+/* Returns the number of free pages in the user and high pools if
+   PAL_USER is set in FLAGS, otherwise in the kernel pool.  The
+   count may be stale by the time the caller looks at it. */
+size_t
+palloc_available (enum palloc_flags flags)
+{
+  if (flags & PAL_USER)
+    return user_pool.free_cnt + high_pool.free_cnt;
+  else
+    return kernel_pool.free_cnt;
+}
+
+/* Returns the total number of pages in the user and high pools if
+   PAL_USER is set in FLAGS, otherwise in the kernel pool. */
+size_t
+palloc_capacity (enum palloc_flags flags)
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
-    PANIC ("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  if (flags & PAL_USER)
+    return (bitmap_size (user_pool.used_map)
+            + (high_pool.used_map != NULL
+               ? bitmap_size (high_pool.used_map) : 0));
+  else
+    return bitmap_size (kernel_pool.used_map);
+}
 
+/* Initializes pool P as holding the PAGE_CNT pages starting at
+   BASE, keeping its bitmap in the BM_SIZE bytes at BM, and naming
+   it NAME for debugging purposes. */
+static void
+init_pool (struct pool *p, void *bm, size_t bm_size, void *base,
+           size_t page_cnt, const char *name) 
+{
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
   /* Initialize the pool. */
   lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+  p->used_map = bitmap_create_in_buf (page_cnt, bm, bm_size);
+  p->free_cnt = page_cnt;
+  p->base = base;
+}
+
+/* Marks PAGE_CNT contiguous free pages in POOL as used and returns
+   the index of the first one, or BITMAP_ERROR if there is no such
+   run of pages. */
+static size_t
+take_pages (struct pool *pool, size_t page_cnt)
+{
+  enum intr_level old_level;
+  size_t page_idx;
+
+  lock_acquire (&pool->lock);
+  old_level = intr_disable ();
+  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+  if (page_idx != BITMAP_ERROR)
+    pool->free_cnt -= page_cnt;
+  intr_set_level (old_level);
+  lock_release (&pool->lock);
+
+  return page_idx;
+}
+
+/* Marks the PAGE_CNT pages in POOL starting at index PAGE_IDX as
+   free. */
+static void
+return_pages (struct pool *pool, size_t page_idx, size_t page_cnt)
+{
+  enum intr_level old_level;
+
+  /* Pages may be freed with interrupts off, in the middle of a
+     thread switch, so we can't take the pool's lock here.
+     Disabling interrupts keeps the bitmap and the free count
+     consistent with concurrent allocations instead. */
+  old_level = intr_disable ();
+  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
+  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  pool->free_cnt += page_cnt;
+  intr_set_level (old_level);
 }
 
 /* Returns true if PAGE was allocated from POOL,
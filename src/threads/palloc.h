@@ -2,6 +2,7 @@
 #define THREADS_PALLOC_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 /* How to allocate pages. */
 enum palloc_flags
@@ -16,5 +17,9 @@ void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+uintptr_t palloc_get_high_page (void);
+void palloc_free_high_page (uintptr_t paddr);
+size_t palloc_available (enum palloc_flags);
+size_t palloc_capacity (enum palloc_flags);
 
 #endif /* threads/palloc.h */
@@ -66,6 +66,8 @@ static inline uintptr_t pd_no (const void *va) {
 #define PTE_U 0x4               /* 1=user/kernel, 0=kernel only. */
 #define PTE_A 0x20              /* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40              /* 1=dirty, 0=not dirty (PTEs only). */
+#define PTE_PS 0x80             /* 1=4 MB page, 0=page table (PDEs only). */
+#define PTE_G 0x100             /* 1=global, 0=flushed by CR3 writes. */
 
 /* Returns a PDE that points to page table PT. */
 static inline uint32_t pde_create (uint32_t *pt) {
@@ -73,28 +75,57 @@ static inline uint32_t pde_create (uint32_t *pt) {
   return vtop (pt) | PTE_U | PTE_P | PTE_W;
 }
 
+/* Returns a PDE that maps the 4 MB region starting at PAGE
+   directly, without a page table.  PAGE must be aligned on a
+   4 MB boundary, and the CPU must have page size extensions
+   enabled (CR4.PSE).
+   If WRITABLE is true then the region will be writable.
+   The region will be usable only by ring 0 code (the kernel),
+   and like other kernel mappings it is global. */
+static inline uint32_t pde_create_large (void *page, bool writable) {
+  ASSERT ((uintptr_t) page % PTSPAN == 0);
+  return vtop (page) | PTE_PS | PTE_G | PTE_P | (writable ? PTE_W : 0);
+}
+
 /* Returns a pointer to the page table that page directory entry
-   PDE, which must "present", points to. */
+   PDE, which must "present" and must not map a 4 MB page,
+   points to. */
 static inline uint32_t *pde_get_pt (uint32_t pde) {
   ASSERT (pde & PTE_P);
+  ASSERT (!(pde & PTE_PS));
   return ptov (pde & PTE_ADDR);
 }
 
 /* Returns a PTE that points to PAGE.
    The PTE's page is readable.
    If WRITABLE is true then it will be writable as well.
-   The page will be usable only by ring 0 code (the kernel). */
+   The page will be usable only by ring 0 code (the kernel).
+
+   Kernel mappings are the same in every page directory, so the
+   PTE is marked global: with CR4.PGE enabled, its TLB entry
+   survives the CR3 reload done on each process switch. */
 static inline uint32_t pte_create_kernel (void *page, bool writable) {
   ASSERT (pg_ofs (page) == 0);
-  return vtop (page) | PTE_P | (writable ? PTE_W : 0);
+  return vtop (page) | PTE_G | PTE_P | (writable ? PTE_W : 0);
 }
 
 /* Returns a PTE that points to PAGE.
    The PTE's page is readable.
    If WRITABLE is true then it will be writable as well.
-   The page will be usable by both user and kernel code. */
+   The page will be usable by both user and kernel code.
+   User mappings differ between processes, so unlike kernel
+   mappings they are never global. */
 static inline uint32_t pte_create_user (void *page, bool writable) {
-  return pte_create_kernel (page, writable) | PTE_U;
+  return (pte_create_kernel (page, writable) & ~PTE_G) | PTE_U;
+}
+
+/* Returns a PTE that points to the page at physical address
+   PADDR, which need not be mapped into the kernel's address
+   space, for use by both user and kernel code, like
+   pte_create_user(). */
+static inline uint32_t pte_create_user_phys (uintptr_t paddr, bool writable) {
+  ASSERT (paddr % PGSIZE == 0);
+  return paddr | PTE_U | PTE_P | (writable ? PTE_W : 0);
 }
 
 /* Returns a pointer to the page that page table entry PTE points
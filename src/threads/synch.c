@@ -336,3 +336,79 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   while (!list_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+/* Initializes wait queue WQ. */
+void
+wait_queue_init (struct wait_queue *wq)
+{
+  ASSERT (wq != NULL);
+
+  list_init (&wq->entries);
+}
+
+/* Initializes ENTRY, which is not in any wait queue. */
+void
+wait_queue_entry_init (struct wait_queue_entry *entry)
+{
+  ASSERT (entry != NULL);
+
+  entry->sema = NULL;
+}
+
+/* Adds ENTRY, which must not be in a wait queue already, to WQ,
+   so that waking WQ will up SEMA. */
+void
+wait_queue_add (struct wait_queue *wq, struct wait_queue_entry *entry,
+                struct semaphore *sema)
+{
+  enum intr_level old_level;
+
+  ASSERT (wq != NULL);
+  ASSERT (entry != NULL && entry->sema == NULL);
+  ASSERT (sema != NULL);
+
+  old_level = intr_disable ();
+  entry->sema = sema;
+  list_push_back (&wq->entries, &entry->elem);
+  intr_set_level (old_level);
+}
+
+/* Removes ENTRY from its wait queue, if it is in one. */
+void
+wait_queue_remove (struct wait_queue_entry *entry)
+{
+  enum intr_level old_level;
+
+  ASSERT (entry != NULL);
+
+  old_level = intr_disable ();
+  if (entry->sema != NULL)
+    {
+      list_remove (&entry->elem);
+      entry->sema = NULL;
+    }
+  intr_set_level (old_level);
+}
+
+/* Ups the semaphore of every entry in WQ.  The entries stay in
+   WQ until their owners remove them.
+
+   This function may be called from an interrupt handler, and it
+   costs next to nothing if no one is waiting. */
+void
+wait_queue_wake (struct wait_queue *wq)
+{
+  enum intr_level old_level;
+  struct list_elem *e;
+
+  ASSERT (wq != NULL);
+
+  if (list_empty (&wq->entries))
+    return;
+
+  old_level = intr_disable ();
+  for (e = list_begin (&wq->entries); e != list_end (&wq->entries);
+       e = list_next (e))
+    sema_up (list_entry (e, struct wait_queue_entry, elem)->sema);
+  intr_set_level (old_level);
+}
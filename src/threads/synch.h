@@ -41,6 +41,31 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Wait queue, for waiting on any of several objects at once.
+   An object that something may wait for keeps a wait queue.  A
+   waiter adds an entry to the queue of each object it is
+   interested in, all naming one semaphore, and then downs the
+   semaphore.  Whenever an object's state changes, it ups the
+   semaphore named by every entry in its queue. */
+struct wait_queue
+  {
+    struct list entries;        /* List of struct wait_queue_entry. */
+  };
+
+/* An entry in a wait queue. */
+struct wait_queue_entry
+  {
+    struct list_elem elem;      /* List element. */
+    struct semaphore *sema;     /* Semaphore to up, or null. */
+  };
+
+void wait_queue_init (struct wait_queue *);
+void wait_queue_entry_init (struct wait_queue_entry *);
+void wait_queue_add (struct wait_queue *, struct wait_queue_entry *,
+                     struct semaphore *);
+void wait_queue_remove (struct wait_queue_entry *);
+void wait_queue_wake (struct wait_queue *);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
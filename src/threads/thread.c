@@ -242,6 +242,28 @@ thread_unblock (struct thread *t)
   intr_set_level (old_level);
 }
 
+/* Puts the current thread to sleep, like thread_block(), and
+   switches straight to blocked thread NEXT, which runs in its
+   place without passing through the ready list.  This is for
+   handing the CPU to a thread that is waiting for the current
+   one, as in synchronous IPC, where it would otherwise have to
+   wait its turn behind every other ready thread.
+
+   This function must be called with interrupts turned off. */
+void
+thread_switch_to (struct thread *next)
+{
+  struct thread *cur = running_thread ();
+
+  ASSERT (!intr_context ());
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (is_thread (next));
+  ASSERT (next != cur && next->status == THREAD_BLOCKED);
+
+  cur->status = THREAD_BLOCKED;
+  thread_schedule_tail (switch_threads (cur, next));
+}
+
 /* Returns the name of the running thread. */
 const char *
 thread_name (void) 
@@ -331,6 +353,26 @@ thread_foreach (thread_action_func *func, void *aux)
     }
 }
 
+/* Returns the thread whose tid is TID, or a null pointer if
+   there is none.
+   This function must be called with interrupts off. */
+struct thread *
+thread_get (tid_t tid)
+{
+  struct list_elem *e;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (e = list_begin (&all_list); e != list_end (&all_list);
+       e = list_next (e))
+    {
+      struct thread *t = list_entry (e, struct thread, allelem);
+      if (t->tid == tid)
+        return t;
+    }
+  return NULL;
+}
+
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void
 thread_set_priority (int new_priority) 
@@ -462,6 +504,14 @@ init_thread (struct thread *t, const char *name, int priority)
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
   t->priority = priority;
+#ifdef USERPROG
+  list_init (&t->children);
+  list_init (&t->ipc_senders);
+  list_init (&t->shm_refs);
+#endif
+#ifdef VM
+  list_init (&t->mappings);
+#endif
   t->magic = THREAD_MAGIC;
 
   old_level = intr_disable ();
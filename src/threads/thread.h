@@ -4,6 +4,9 @@
 #include <debug.h>
 #include <list.h>
 #include <stdint.h>
+#ifdef VM
+#include <memstat.h>
+#endif
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -96,6 +99,40 @@ struct thread
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
+    struct file *exec_file;             /* Executable, open while running. */
+    struct child *child;                /* Exit status, shared with parent. */
+    struct list children;               /* Children's `struct child's. */
+
+    /* Owned by userprog/syscall.c. */
+    void *user_esp;                     /* User %esp at system call entry. */
+
+    /* Owned by userprog/fd.c. */
+    struct open_file **files;           /* Open files, indexed by fd. */
+
+    /* Owned by userprog/ring.c. */
+    struct ring_ctx *ring;              /* Submission ring, if any. */
+
+    /* Owned by userprog/ipc.c. */
+    struct ipc_wait *ipc;               /* IPC we are blocked in, if any. */
+    struct list ipc_senders;            /* Callers waiting for us. */
+
+    /* Owned by userprog/shm.c. */
+    struct list shm_refs;               /* Shared memory segments held. */
+#endif
+
+#ifdef VM
+    /* Owned by vm/page.c. */
+    struct hash *pages;                 /* Supplemental page table. */
+
+    /* Updated by vm/page.c and vm/frame.c. */
+    struct memstat memstat;             /* Memory statistics. */
+
+    /* Owned by vm/readahead.c. */
+    struct readahead *readahead;        /* Sequential fault tracking. */
+
+    /* Owned by vm/mmap.c. */
+    struct list mappings;               /* Memory-mapped files. */
+    int next_mapid;                     /* Next mapping identifier. */
 #endif
 
     /* Owned by thread.c. */
@@ -118,6 +155,7 @@ tid_t thread_create (const char *name, int priority, thread_func *, void *);
 
 void thread_block (void);
 void thread_unblock (struct thread *);
+void thread_switch_to (struct thread *);
 
 struct thread *thread_current (void);
 tid_t thread_tid (void);
@@ -129,6 +167,7 @@ void thread_yield (void);
 /* Performs some operation on thread t, given auxiliary data AUX. */
 typedef void thread_action_func (struct thread *t, void *aux);
 void thread_foreach (thread_action_func *, void *);
+struct thread *thread_get (tid_t);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
@@ -2,8 +2,12 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/uaccess.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -148,9 +152,29 @@ page_fault (struct intr_frame *f)
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
-  /* To implement virtual memory, delete the rest of the function
-     body, and replace it with code that brings in the page to
-     which fault_addr refers. */
+#ifdef VM
+  /* A user page that is not present may simply not have been
+     loaded yet.  Bring it in and restart the faulting
+     instruction.  If the kernel faulted while accessing user
+     memory for a system call, the user stack pointer is the one
+     saved at system call entry. */
+  if (not_present
+      && page_fault_in (fault_addr, write,
+                        user ? f->esp : thread_current ()->user_esp))
+    return;
+
+  /* Writing a present, read-only page may be the first write to
+     a page shared copy-on-write with another process since a
+     fork(), or to a zero-fill page mapped to the zero page. */
+  if (!not_present && write && page_copy_on_write (fault_addr))
+    return;
+#endif
+
+  /* A bad pointer passed to a system call.  Make the access
+     fail rather than the kernel. */
+  if (!user && uaccess_fixup (f))
+    return;
+
   printf ("Page fault at %p: %s error %s page in %s context.\n",
           fault_addr,
           not_present ? "not present" : "rights violation",
@@ -0,0 +1,354 @@
+#include "userprog/fd.h"
+#include <debug.h>
+#include <stdio.h>
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "userprog/pipe.h"
+
+/* File descriptor tables.
+
+   Each process has an array of open file descriptions, indexed
+   by file descriptor.  A description refers to a file, to one
+   end of a pipe, or to the console.  dup() and dup2() make
+   several descriptors share one description, and with it a file
+   position, but descriptions are never shared between processes:
+   fork() gives the child its own copy of each one.
+
+   Descriptors STDIN_FILENO and STDOUT_FILENO stand for the
+   console while they have no entry of their own.  They can be
+   redirected with dup2(), and closing them then makes them stand
+   for the console again, so the lowest descriptor ever handed
+   out by open(), pipe(), or dup() is 2.  As in Unix, a new
+   descriptor is the lowest free one.
+
+   A process started by exec() inherits its parent's standard
+   input and output, so that a shell can connect programs with
+   pipes, but no other descriptors. */
+
+/* Lowest descriptor that can be handed out. */
+#define FD_FIRST 2
+
+/* The console's open file descriptions. */
+static struct open_file console_in = {FD_CONSOLE_IN, 1, NULL, NULL};
+static struct open_file console_out = {FD_CONSOLE_OUT, 1, NULL, NULL};
+
+static struct open_file *open_file_copy (const struct open_file *);
+static void open_file_release (struct open_file *);
+static int install (struct open_file *);
+
+/* Creates a file descriptor table for the running thread.  If
+   PARENT is nonnull, the new table gets a copy of PARENT's
+   standard input and output, for exec().  PARENT must stay
+   blocked until we are done.  Returns true if successful, false
+   on memory allocation failure. */
+bool
+fd_table_init (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  bool success = true;
+  int fd;
+
+  ASSERT (t->files == NULL);
+  t->files = calloc (FD_MAX, sizeof *t->files);
+  if (t->files == NULL)
+    return false;
+  if (parent == NULL || parent->files == NULL)
+    return true;
+
+  lock_acquire (&filesys_lock);
+  for (fd = 0; fd < FD_FIRST && success; fd++)
+    if (parent->files[fd] != NULL)
+      {
+        t->files[fd] = open_file_copy (parent->files[fd]);
+        success = t->files[fd] != NULL;
+      }
+  lock_release (&filesys_lock);
+  return success;
+}
+
+/* Creates a file descriptor table for the running thread that
+   holds, for fork(), a copy of each of PARENT's open file
+   descriptions under the same descriptors.  Files are reopened,
+   so each has its own position, which starts out equal to the
+   original's.  PARENT must stay blocked until we are done.
+   Returns true if successful, false on memory allocation
+   failure. */
+bool
+fd_table_copy (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  bool success = true;
+  int fd;
+
+  if (!fd_table_init (NULL))
+    return false;
+  if (parent->files == NULL)
+    return true;
+
+  lock_acquire (&filesys_lock);
+  for (fd = 0; fd < FD_MAX && success; fd++)
+    if (parent->files[fd] != NULL)
+      {
+        int dup_fd;
+
+        /* Keep descriptors that share a description in the
+           parent sharing one in the child. */
+        for (dup_fd = 0; dup_fd < fd; dup_fd++)
+          if (parent->files[dup_fd] == parent->files[fd])
+            break;
+        if (dup_fd < fd)
+          {
+            t->files[fd] = t->files[dup_fd];
+            t->files[fd]->ref_cnt++;
+          }
+        else
+          {
+            t->files[fd] = open_file_copy (parent->files[fd]);
+            success = t->files[fd] != NULL;
+          }
+      }
+  lock_release (&filesys_lock);
+  return success;
+}
+
+/* Closes every descriptor in the running thread's file
+   descriptor table and destroys the table. */
+void
+fd_table_destroy (void)
+{
+  struct thread *t = thread_current ();
+  int fd;
+
+  if (t->files == NULL)
+    return;
+
+  for (fd = 0; fd < FD_MAX; fd++)
+    fd_close (fd);
+  free (t->files);
+  t->files = NULL;
+}
+
+/* Enters FILE in the running thread's file descriptor table and
+   returns its new descriptor, or -1 if the table is full or
+   memory is short.  On failure, the caller still owns FILE. */
+int
+fd_install (struct file *file)
+{
+  struct open_file *of;
+  int fd;
+
+  ASSERT (file != NULL);
+
+  of = malloc (sizeof *of);
+  if (of == NULL)
+    return -1;
+  of->type = FD_FILE;
+  of->ref_cnt = 1;
+  of->file = file;
+  of->pipe = NULL;
+
+  fd = install (of);
+  if (fd < 0)
+    free (of);
+  return fd;
+}
+
+/* Enters both ends of newly created pipe P in the running
+   thread's file descriptor table, storing the read end's
+   descriptor into FDS[0] and the write end's into FDS[1].
+   Returns true if successful.  On failure, returns false and
+   closes both ends of P, which frees it. */
+bool
+fd_install_pipe (struct pipe *p, int fds[2])
+{
+  int i;
+
+  fds[0] = fds[1] = -1;
+  for (i = 0; i < 2; i++)
+    {
+      struct open_file *of = malloc (sizeof *of);
+
+      if (of == NULL)
+        break;
+      of->type = i == 0 ? FD_PIPE_READ : FD_PIPE_WRITE;
+      of->ref_cnt = 1;
+      of->file = NULL;
+      of->pipe = p;
+      fds[i] = install (of);
+      if (fds[i] < 0)
+        {
+          free (of);
+          break;
+        }
+    }
+  if (i == 2)
+    return true;
+
+  /* Close whatever we installed, and the rest of the pipe. */
+  if (fds[0] >= 0)
+    fd_close (fds[0]);
+  else
+    pipe_close (p, false);
+  pipe_close (p, true);
+  return false;
+}
+
+/* Returns the open file description that descriptor FD refers
+   to in the running thread, or a null pointer if FD is not
+   open. */
+struct open_file *
+fd_get (int fd)
+{
+  struct thread *t = thread_current ();
+
+  if (fd < 0 || fd >= FD_MAX)
+    return NULL;
+  if (t->files != NULL && t->files[fd] != NULL)
+    return t->files[fd];
+  return (fd == STDIN_FILENO ? &console_in
+          : fd == STDOUT_FILENO ? &console_out
+          : NULL);
+}
+
+/* Returns the file that descriptor FD refers to in the running
+   thread, or a null pointer if FD is not open or does not refer
+   to a file. */
+struct file *
+fd_lookup (int fd)
+{
+  struct open_file *of = fd_get (fd);
+
+  return of != NULL && of->type == FD_FILE ? of->file : NULL;
+}
+
+/* Closes descriptor FD in the running thread, if it is open.
+   The file or pipe end it refers to is closed once no descriptor
+   refers to it any longer.  Must not be called with
+   filesys_lock held. */
+void
+fd_close (int fd)
+{
+  struct thread *t = thread_current ();
+  struct open_file *of;
+
+  if (t->files == NULL || fd < 0 || fd >= FD_MAX || t->files[fd] == NULL)
+    return;
+  of = t->files[fd];
+  t->files[fd] = NULL;
+  open_file_release (of);
+}
+
+/* Makes a new descriptor in the running thread that refers to
+   the same open file description as FD, as the lowest free
+   descriptor.  Returns the new descriptor, or -1 if FD is not
+   open or the table is full. */
+int
+fd_dup (int fd)
+{
+  struct open_file *of = fd_get (fd);
+  int new_fd;
+
+  if (of == NULL)
+    return -1;
+  new_fd = install (of);
+  if (new_fd >= 0)
+    of->ref_cnt++;
+  return new_fd;
+}
+
+/* Makes descriptor NEW_FD in the running thread refer to the
+   same open file description as OLD_FD, closing NEW_FD first if
+   it was open.  Returns NEW_FD, or -1 if OLD_FD is not open or
+   NEW_FD is out of range.  Must not be called with filesys_lock
+   held. */
+int
+fd_dup2 (int old_fd, int new_fd)
+{
+  struct thread *t = thread_current ();
+  struct open_file *of = fd_get (old_fd);
+
+  if (of == NULL || t->files == NULL || new_fd < 0 || new_fd >= FD_MAX)
+    return -1;
+  if (old_fd == new_fd)
+    return new_fd;
+
+  of->ref_cnt++;
+  fd_close (new_fd);
+  t->files[new_fd] = of;
+  return new_fd;
+}
+
+/* Returns a new open file description, for another process,
+   that refers to the same thing as OF, or a null pointer if
+   memory is short.  A file is reopened at the same position.
+   The caller must hold filesys_lock. */
+static struct open_file *
+open_file_copy (const struct open_file *of)
+{
+  struct open_file *copy;
+
+  ASSERT (lock_held_by_current_thread (&filesys_lock));
+
+  if (of == &console_in || of == &console_out)
+    return (struct open_file *) of;
+
+  copy = malloc (sizeof *copy);
+  if (copy == NULL)
+    return NULL;
+  *copy = *of;
+  copy->ref_cnt = 1;
+  if (of->type == FD_FILE)
+    {
+      copy->file = file_reopen (of->file);
+      if (copy->file == NULL)
+        {
+          free (copy);
+          return NULL;
+        }
+      file_seek (copy->file, file_tell (of->file));
+    }
+  else
+    pipe_open (of->pipe, of->type == FD_PIPE_WRITE);
+  return copy;
+}
+
+/* Drops a descriptor's reference to OF, closing and freeing it
+   once there are no more. */
+static void
+open_file_release (struct open_file *of)
+{
+  if (of == &console_in || of == &console_out || --of->ref_cnt > 0)
+    return;
+
+  if (of->type == FD_FILE)
+    {
+      lock_acquire (&filesys_lock);
+      file_close (of->file);
+      lock_release (&filesys_lock);
+    }
+  else
+    pipe_close (of->pipe, of->type == FD_PIPE_WRITE);
+  free (of);
+}
+
+/* Enters OF in the running thread's file descriptor table under
+   the lowest free descriptor and returns it, or -1 if the table
+   is full.  Does not touch OF's reference count. */
+static int
+install (struct open_file *of)
+{
+  struct thread *t = thread_current ();
+  int fd;
+
+  if (t->files != NULL)
+    for (fd = FD_FIRST; fd < FD_MAX; fd++)
+      if (t->files[fd] == NULL)
+        {
+          t->files[fd] = of;
+          return fd;
+        }
+  return -1;
+}
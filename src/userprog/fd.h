@@ -0,0 +1,45 @@
+#ifndef USERPROG_FD_H
+#define USERPROG_FD_H
+
+#include <stdbool.h>
+
+struct file;
+struct pipe;
+struct thread;
+
+/* Maximum number of file descriptors per process, including the
+   console's. */
+#define FD_MAX 128
+
+/* What a file descriptor refers to. */
+enum fd_type
+  {
+    FD_CONSOLE_IN,              /* Keyboard. */
+    FD_CONSOLE_OUT,             /* Console display. */
+    FD_FILE,                    /* File. */
+    FD_PIPE_READ,               /* Read end of a pipe. */
+    FD_PIPE_WRITE               /* Write end of a pipe. */
+  };
+
+/* An open file description, shared by descriptors made with
+   dup() or dup2(). */
+struct open_file
+  {
+    enum fd_type type;          /* What it refers to. */
+    int ref_cnt;                /* Number of descriptors. */
+    struct file *file;          /* File, if FD_FILE. */
+    struct pipe *pipe;          /* Pipe, if FD_PIPE_*. */
+  };
+
+bool fd_table_init (struct thread *parent);
+bool fd_table_copy (struct thread *parent);
+void fd_table_destroy (void);
+int fd_install (struct file *);
+bool fd_install_pipe (struct pipe *, int fds[2]);
+struct open_file *fd_get (int fd);
+struct file *fd_lookup (int fd);
+void fd_close (int fd);
+int fd_dup (int fd);
+int fd_dup2 (int old_fd, int new_fd);
+
+#endif /* userprog/fd.h */
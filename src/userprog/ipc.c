@@ -0,0 +1,214 @@
+#include "userprog/ipc.h"
+#include <debug.h>
+#include <list.h>
+
+/* Synchronous IPC.
+
+   A client sends a short message to a server with ipc_call()
+   and blocks until the server replies.  A server replies to its
+   last client and waits for its next message in a single call,
+   ipc_reply_wait().  Messages, described in lib/ipc.h, travel
+   in the %ebx, %esi, and %edi registers, so the kernel copies
+   them straight from one thread's interrupt frame into the
+   other's, touching no user memory on either side.
+
+   In a client/server loop, the peer is already blocked waiting
+   when a message arrives for it, so the sender blocks and
+   switches directly to it with thread_switch_to(), skipping the
+   ready list and the scheduler.  A round trip then costs two
+   system calls and two thread switches.  A client that calls a
+   server that is busy waits in the server's `ipc_senders' list.
+
+   Everything here runs with interrupts off, which keeps the two
+   sides consistent, as in threads/synch.c.  Whoever wakes a
+   blocked thread also clears its `ipc' member, so that no one
+   else can deliver to it in the meantime. */
+
+/* What a thread blocked in IPC is waiting for. */
+enum ipc_state
+  {
+    IPC_SENDING,                /* Server to take our call. */
+    IPC_CALLING,                /* Server to reply. */
+    IPC_RECEIVING               /* A call. */
+  };
+
+/* A thread blocked in IPC.  Lives on the thread's kernel stack
+   and is pointed to by its `ipc' member. */
+struct ipc_wait
+  {
+    enum ipc_state state;       /* What we are waiting for. */
+    struct thread *thread;      /* Blocked thread. */
+    struct intr_frame *frame;   /* Registers that hold the message. */
+    struct thread *server;      /* Server, while sending or calling. */
+    int result;                 /* Return value, set by the waker. */
+    struct list_elem elem;      /* In server's `ipc_senders'. */
+  };
+
+static struct thread *find_process (tid_t);
+static void copy_msg (struct intr_frame *dst, const struct intr_frame *src);
+static void fail_caller (struct thread *, void *server);
+
+/* Sends the message in F's registers to the process whose tid is
+   SERVER and waits for its reply, which replaces the message in
+   F's registers.  Returns 0 if successful, -1 if SERVER does not
+   exist or exits before replying. */
+int
+ipc_call (tid_t server_tid, struct intr_frame *f)
+{
+  struct thread *cur = thread_current ();
+  struct thread *server;
+  struct ipc_wait w;
+  enum intr_level old_level;
+
+  ASSERT (f != NULL);
+
+  old_level = intr_disable ();
+  server = find_process (server_tid);
+  if (server == NULL || server == cur)
+    {
+      intr_set_level (old_level);
+      return -1;
+    }
+
+  w.thread = cur;
+  w.frame = f;
+  w.server = server;
+  w.result = 0;
+  cur->ipc = &w;
+  if (server->ipc != NULL && server->ipc->state == IPC_RECEIVING)
+    {
+      /* Deliver, then run the server right away. */
+      copy_msg (server->ipc->frame, f);
+      server->ipc->result = cur->tid;
+      server->ipc = NULL;
+      w.state = IPC_CALLING;
+      thread_switch_to (server);
+    }
+  else
+    {
+      w.state = IPC_SENDING;
+      list_push_back (&server->ipc_senders, &w.elem);
+      thread_block ();
+    }
+  intr_set_level (old_level);
+  return w.result;
+}
+
+/* If CLIENT is not TID_ERROR, sends the message in F's registers
+   as the reply to CLIENT's pending call to the running process.
+   Then waits for the next call to the running process and puts
+   its message in F's registers.  Returns the caller's tid, or
+   TID_ERROR if CLIENT is not waiting for a reply from the running
+   process, in which case nothing is sent or received. */
+tid_t
+ipc_reply_wait (tid_t client_tid, struct intr_frame *f)
+{
+  struct thread *cur = thread_current ();
+  struct thread *client = NULL;
+  struct ipc_wait w;
+  enum intr_level old_level;
+
+  ASSERT (f != NULL);
+
+  old_level = intr_disable ();
+  if (client_tid != TID_ERROR)
+    {
+      client = find_process (client_tid);
+      if (client == NULL || client->ipc == NULL
+          || client->ipc->state != IPC_CALLING
+          || client->ipc->server != cur)
+        {
+          intr_set_level (old_level);
+          return TID_ERROR;
+        }
+      copy_msg (client->ipc->frame, f);
+      client->ipc = NULL;
+    }
+
+  if (!list_empty (&cur->ipc_senders))
+    {
+      /* A call is already waiting.  Take it without blocking,
+         and let the client we replied to wait its turn. */
+      struct ipc_wait *sender;
+
+      sender = list_entry (list_pop_front (&cur->ipc_senders),
+                           struct ipc_wait, elem);
+      copy_msg (f, sender->frame);
+      sender->state = IPC_CALLING;
+      if (client != NULL)
+        thread_unblock (client);
+      intr_set_level (old_level);
+      return sender->thread->tid;
+    }
+
+  w.state = IPC_RECEIVING;
+  w.thread = cur;
+  w.frame = f;
+  w.server = NULL;
+  w.result = TID_ERROR;
+  cur->ipc = &w;
+  if (client != NULL)
+    thread_switch_to (client);
+  else
+    thread_block ();
+  intr_set_level (old_level);
+  return w.result;
+}
+
+/* Fails every call waiting for the running process, which is
+   exiting.  Must be called after the process's page directory
+   is gone, so that find_process() no longer lets new calls
+   in. */
+void
+ipc_exit (void)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  while (!list_empty (&cur->ipc_senders))
+    {
+      struct ipc_wait *sender;
+
+      sender = list_entry (list_pop_front (&cur->ipc_senders),
+                           struct ipc_wait, elem);
+      sender->result = -1;
+      sender->thread->ipc = NULL;
+      thread_unblock (sender->thread);
+    }
+  thread_foreach (fail_caller, cur);
+  intr_set_level (old_level);
+}
+
+/* Returns the running user process whose tid is TID, or a null
+   pointer if there is none.  Interrupts must be off. */
+static struct thread *
+find_process (tid_t tid)
+{
+  struct thread *t = thread_get (tid);
+
+  return t != NULL && t->pagedir != NULL ? t : NULL;
+}
+
+/* Copies the message in SRC's registers into DST's. */
+static void
+copy_msg (struct intr_frame *dst, const struct intr_frame *src)
+{
+  dst->ebx = src->ebx;
+  dst->esi = src->esi;
+  dst->edi = src->edi;
+}
+
+/* Thread action function for ipc_exit() that wakes T, with a
+   result of -1, if it is waiting for a reply from SERVER. */
+static void
+fail_caller (struct thread *t, void *server)
+{
+  if (t->ipc != NULL && t->ipc->state == IPC_CALLING
+      && t->ipc->server == server)
+    {
+      t->ipc->result = -1;
+      t->ipc = NULL;
+      thread_unblock (t);
+    }
+}
@@ -0,0 +1,11 @@
+#ifndef USERPROG_IPC_H
+#define USERPROG_IPC_H
+
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+int ipc_call (tid_t server, struct intr_frame *);
+tid_t ipc_reply_wait (tid_t client, struct intr_frame *);
+void ipc_exit (void);
+
+#endif /* userprog/ipc.h */
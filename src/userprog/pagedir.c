@@ -6,19 +6,34 @@
 #include "threads/pte.h"
 #include "threads/palloc.h"
 
+/* Largest number of pages that pagedir_invalidate_range() will
+   flush one at a time with invlpg.  Beyond this, reloading CR3
+   and refilling the TLB is cheaper. */
+#define INVLPG_MAX 32
+
 static uint32_t *active_pd (void);
 static void invalidate_pagedir (uint32_t *);
+static void invalidate_page (uint32_t *, const void *);
 
 /* Creates a new page directory that has mappings for kernel
    virtual addresses, but none for user virtual addresses.
    Returns the new page directory, or a null pointer if memory
-   allocation fails. */
+   allocation fails.
+
+   The kernel PDEs are copied from init_page_dir, so every page
+   directory shares the kernel's page tables and 4 MB pages
+   rather than getting copies of its own. */
 uint32_t *
 pagedir_create (void) 
 {
   uint32_t *pd = palloc_get_page (0);
   if (pd != NULL)
-    memcpy (pd, init_page_dir, PGSIZE);
+    {
+      size_t kernel_pde = pd_no (PHYS_BASE);
+      memset (pd, 0, kernel_pde * sizeof *pd);
+      memcpy (pd + kernel_pde, init_page_dir + kernel_pde,
+              PGSIZE - kernel_pde * sizeof *pd);
+    }
   return pd;
 }
 
@@ -47,6 +62,45 @@ pagedir_destroy (uint32_t *pd)
   palloc_free_page (pd);
 }
 
+/* Copies every user page mapped in page directory SRC into a
+   new page from the user pool, mapped at the same address and
+   with the same permissions in page directory DST, which must
+   not map any of those addresses yet.  Returns true if
+   successful, false if memory runs out, in which case DST may
+   be partially filled in. */
+bool
+pagedir_copy (uint32_t *dst, uint32_t *src)
+{
+  uint32_t *pde;
+
+  ASSERT (src != init_page_dir);
+  for (pde = src; pde < src + pd_no (PHYS_BASE); pde++)
+    if (*pde & PTE_P)
+      {
+        uint32_t *pt = pde_get_pt (*pde);
+        size_t i;
+
+        for (i = 0; i < PGSIZE / sizeof *pt; i++)
+          if (pt[i] & PTE_P)
+            {
+              void *upage = (void *) (((pde - src) << PDSHIFT)
+                                      | (i << PTSHIFT));
+              void *kpage = palloc_get_page (PAL_USER);
+
+              if (kpage == NULL)
+                return false;
+              memcpy (kpage, pte_get_page (pt[i]), PGSIZE);
+              if (!pagedir_set_page (dst, upage, kpage,
+                                     (pt[i] & PTE_W) != 0))
+                {
+                  palloc_free_page (kpage);
+                  return false;
+                }
+            }
+      }
+  return true;
+}
+
 /* Returns the address of the page table entry for virtual
    address VADDR in page directory PD.
    If PD does not have a page table for VADDR, behavior depends
@@ -97,13 +151,24 @@ lookup_page (uint32_t *pd, const void *vaddr, bool create)
    failed. */
 bool
 pagedir_set_page (uint32_t *pd, void *upage, void *kpage, bool writable)
+{
+  ASSERT (pg_ofs (kpage) == 0);
+  ASSERT (vtop (kpage) >> PTSHIFT < init_ram_pages);
+
+  return pagedir_set_phys (pd, upage, vtop (kpage), writable);
+}
+
+/* Like pagedir_set_page(), but takes the physical address PADDR
+   of the frame, which may lie in high memory, instead of a
+   kernel virtual address. */
+bool
+pagedir_set_phys (uint32_t *pd, void *upage, uintptr_t paddr, bool writable)
 {
   uint32_t *pte;
 
   ASSERT (pg_ofs (upage) == 0);
-  ASSERT (pg_ofs (kpage) == 0);
   ASSERT (is_user_vaddr (upage));
-  ASSERT (vtop (kpage) >> PTSHIFT < init_ram_pages);
+  ASSERT (paddr >> PTSHIFT < init_ram_pages + init_high_pages);
   ASSERT (pd != init_page_dir);
 
   pte = lookup_page (pd, upage, true);
@@ -111,7 +176,7 @@ pagedir_set_page (uint32_t *pd, void *upage, void *kpage, bool writable)
   if (pte != NULL) 
     {
       ASSERT ((*pte & PTE_P) == 0);
-      *pte = pte_create_user (kpage, writable);
+      *pte = pte_create_user_phys (paddr, writable);
       return true;
     }
   else
@@ -136,6 +201,23 @@ pagedir_get_page (uint32_t *pd, const void *uaddr)
     return NULL;
 }
 
+/* Returns the physical address of the page that user virtual
+   page UPAGE maps to in PD, or 0 if UPAGE is unmapped.  Unlike
+   pagedir_get_page(), works for pages in high memory. */
+uintptr_t
+pagedir_get_phys (uint32_t *pd, const void *upage)
+{
+  uint32_t *pte;
+
+  ASSERT (is_user_vaddr (upage));
+
+  pte = lookup_page (pd, upage, false);
+  if (pte != NULL && (*pte & PTE_P) != 0)
+    return *pte & PTE_ADDR;
+  else
+    return 0;
+}
+
 /* Marks user virtual page UPAGE "not present" in page
    directory PD.  Later accesses to the page will fault.  Other
    bits in the page table entry are preserved.
@@ -152,10 +234,43 @@ pagedir_clear_page (uint32_t *pd, void *upage)
   if (pte != NULL && (*pte & PTE_P) != 0)
     {
       *pte &= ~PTE_P;
-      invalidate_pagedir (pd);
+      invalidate_page (pd, upage);
     }
 }
 
+/* Marks the PAGE_CNT user virtual pages starting at UPAGE "not
+   present" in page directory PD, as if by calling
+   pagedir_clear_page() on each of them, but invalidates the TLB
+   only once for the whole range.
+   The pages need not be mapped. */
+void
+pagedir_clear_range (uint32_t *pd, void *upage, size_t page_cnt) 
+{
+  uint8_t *page = upage;
+  size_t i;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (page_cnt <= (size_t) ((uint8_t *) PHYS_BASE - page) / PGSIZE);
+
+  for (i = 0; i < page_cnt; i++) 
+    {
+      uint32_t *pte = lookup_page (pd, page + i * PGSIZE, false);
+      if (pte != NULL)
+        *pte &= ~PTE_P;
+    }
+  pagedir_invalidate_range (pd, upage, page_cnt);
+}
+
+/* Returns true if virtual page VPAGE is present and writable in
+   PD, false otherwise. */
+bool
+pagedir_is_writable (uint32_t *pd, const void *vpage)
+{
+  uint32_t *pte = lookup_page (pd, vpage, false);
+  return pte != NULL && (*pte & (PTE_P | PTE_W)) == (PTE_P | PTE_W);
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PD is dirty,
    that is, if the page has been modified since the PTE was
    installed.
@@ -180,11 +295,27 @@ pagedir_set_dirty (uint32_t *pd, const void *vpage, bool dirty)
       else 
         {
           *pte &= ~(uint32_t) PTE_D;
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
 
+/* Makes the mapping of virtual page VPAGE in PD writable if
+   WRITABLE is true, read-only otherwise.  VPAGE must be
+   mapped. */
+void
+pagedir_set_writable (uint32_t *pd, const void *vpage, bool writable)
+{
+  uint32_t *pte = lookup_page (pd, vpage, false);
+
+  ASSERT (pte != NULL && (*pte & PTE_P) != 0);
+  if (writable)
+    *pte |= PTE_W;
+  else
+    *pte &= ~(uint32_t) PTE_W;
+  invalidate_page (pd, vpage);
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PD has been
    accessed recently, that is, between the time the PTE was
    installed and the last time it was cleared.  Returns false if
@@ -209,13 +340,15 @@ pagedir_set_accessed (uint32_t *pd, const void *vpage, bool accessed)
       else 
         {
           *pte &= ~(uint32_t) PTE_A; 
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
 
 /* Loads page directory PD into the CPU's page directory base
-   register. */
+   register.  This flushes the TLB entries for user mappings, but
+   the global kernel mappings created by paging_init() stay
+   cached. */
 void
 pagedir_activate (uint32_t *pd) 
 {
@@ -243,7 +376,26 @@ active_pd (void)
   return ptov (pd);
 }
 
-/* Seom page table changes can cause the CPU's translation
+/* Flushes the TLB entries for the PAGE_CNT user virtual pages
+   starting at UPAGE in PD, for use after changing their PTEs in
+   a batch.  Small ranges are flushed one page at a time; larger
+   ones flush the whole TLB, since past a point the individual
+   invalidations cost more than refilling the TLB.  Does nothing
+   if PD is not the active page directory. */
+void
+pagedir_invalidate_range (uint32_t *pd, const void *upage, size_t page_cnt) 
+{
+  const uint8_t *page = upage;
+  size_t i;
+
+  if (page_cnt > INVLPG_MAX)
+    invalidate_pagedir (pd);
+  else
+    for (i = 0; i < page_cnt; i++)
+      invalidate_page (pd, page + i * PGSIZE);
+}
+
+/* Some page table changes can cause the CPU's translation
    lookaside buffer (TLB) to become out-of-sync with the page
    table.  When this happens, we have to "invalidate" the TLB by
    re-activating it.
@@ -261,3 +413,17 @@ invalidate_pagedir (uint32_t *pd)
       pagedir_activate (pd);
     } 
 }
+
+/* Invalidates the TLB entry for virtual page VADDR if PD is the
+   active page directory.  This is much cheaper than
+   invalidate_pagedir() when only one PTE has changed, because
+   the rest of the TLB stays intact. */
+static void
+invalidate_page (uint32_t *pd, const void *vaddr) 
+{
+  if (active_pd () == pd) 
+    {
+      /* See [IA32-v2a] "INVLPG--Invalidate TLB Entry". */
+      asm volatile ("invlpg (%0)" : : "r" (vaddr) : "memory");
+    }
+}
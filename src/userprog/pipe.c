@@ -0,0 +1,291 @@
+#include "userprog/pipe.h"
+#include <debug.h>
+#include <poll.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Anonymous pipes.
+
+   A pipe's data lives in a one-page ring buffer.  Only a reader
+   advances `head' and only a writer advances `tail', so a single
+   reader and a single writer need no lock between them: each
+   copies its data first and then publishes it by moving its own
+   index.  Several processes can hold either end, after fork() or
+   dup(), so readers take `read_lock' among themselves and
+   writers take `write_lock', but a reader and a writer never
+   wait for each other's lock.
+
+   pipe_read() and pipe_write() never block.  They move what they
+   can and return, so that the caller, which has the user buffer
+   pinned, can unpin it before waiting with pipe_wait().  Sleeping
+   with the page pinned could deadlock: after fork(), the page may
+   be shared copy-on-write with the very process at the other end
+   of the pipe, which would then wait for it to be unpinned before
+   it could bring it in.
+
+   A reader waits only when the ring is empty and a writer only
+   when it is full.  A thread about to block first announces it
+   by setting `reader_waiting' or `writer_waiting', then checks
+   the ring once more before going to sleep on its semaphore.
+   Its peer only calls sema_up() when it sees the flag, so the
+   common case, with nobody waiting, makes no wakeup calls at
+   all.  The semaphore counts, so a wakeup that arrives between
+   the second check and sema_down() is not lost; a stale count
+   only causes a spurious wakeup, after which the sleeper checks
+   again.  Threads in poll() wait on `pollers' instead, which also
+   costs nothing to wake when empty. */
+
+/* Bytes in a pipe's ring buffer. */
+#define PIPE_SIZE PGSIZE
+
+/* A pipe. */
+struct pipe
+  {
+    uint8_t *buf;               /* Ring buffer, PIPE_SIZE bytes. */
+    volatile unsigned head;     /* Total bytes ever read. */
+    volatile unsigned tail;     /* Total bytes ever written. */
+
+    volatile bool reader_waiting; /* Reader asleep on `readable'? */
+    volatile bool writer_waiting; /* Writer asleep on `writable'? */
+    struct semaphore readable;  /* Upped when data or EOF arrives. */
+    struct semaphore writable;  /* Upped when space arrives. */
+    struct lock read_lock;      /* Serializes readers. */
+    struct lock write_lock;     /* Serializes writers. */
+    struct wait_queue pollers;  /* Woken on any change. */
+
+    struct lock lock;           /* Protects the counts below. */
+    volatile int readers;       /* Number of open read ends. */
+    volatile int writers;       /* Number of open write ends. */
+  };
+
+static void wake_reader (struct pipe *);
+static void wake_writer (struct pipe *);
+
+/* Creates and returns a new, empty pipe with one read end and
+   one write end open, or a null pointer if memory allocation
+   fails. */
+struct pipe *
+pipe_create (void)
+{
+  struct pipe *p = malloc (sizeof *p);
+
+  if (p == NULL)
+    return NULL;
+  p->buf = palloc_get_page (0);
+  if (p->buf == NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  p->head = p->tail = 0;
+  p->reader_waiting = p->writer_waiting = false;
+  sema_init (&p->readable, 0);
+  sema_init (&p->writable, 0);
+  lock_init (&p->read_lock);
+  lock_init (&p->write_lock);
+  wait_queue_init (&p->pollers);
+  lock_init (&p->lock);
+  p->readers = p->writers = 1;
+  return p;
+}
+
+/* Opens another read end of P, or another write end if WRITER
+   is true. */
+void
+pipe_open (struct pipe *p, bool writer)
+{
+  lock_acquire (&p->lock);
+  if (writer)
+    p->writers++;
+  else
+    p->readers++;
+  lock_release (&p->lock);
+}
+
+/* Closes a read end of P, or a write end if WRITER is true.
+   Closing the last write end lets readers see end of file, and
+   closing the last read end makes writes fail.  Frees P when
+   both ends are entirely closed. */
+void
+pipe_close (struct pipe *p, bool writer)
+{
+  bool destroy;
+
+  lock_acquire (&p->lock);
+  if (writer)
+    {
+      ASSERT (p->writers > 0);
+      p->writers--;
+    }
+  else
+    {
+      ASSERT (p->readers > 0);
+      p->readers--;
+    }
+  destroy = p->readers == 0 && p->writers == 0;
+  if (!destroy && writer && p->writers == 0)
+    wake_reader (p);
+  else if (!destroy && !writer && p->readers == 0)
+    wake_writer (p);
+  if (!destroy)
+    wait_queue_wake (&p->pollers);
+  lock_release (&p->lock);
+
+  if (destroy)
+    {
+      palloc_free_page (p->buf);
+      free (p);
+    }
+}
+
+/* Reads up to SIZE bytes from P into BUFFER, without blocking.
+   Returns the number of bytes read, which is 0 if P is empty. */
+int
+pipe_read (struct pipe *p, void *buffer_, size_t size)
+{
+  uint8_t *buffer = buffer_;
+  size_t avail, ofs, first;
+
+  lock_acquire (&p->read_lock);
+  avail = p->tail - p->head;
+  if (avail > size)
+    avail = size;
+  if (avail > 0)
+    {
+      ofs = p->head % PIPE_SIZE;
+      first = avail < PIPE_SIZE - ofs ? avail : PIPE_SIZE - ofs;
+      memcpy (buffer, p->buf + ofs, first);
+      memcpy (buffer + first, p->buf, avail - first);
+      barrier ();
+      p->head += avail;
+
+      if (p->writer_waiting)
+        wake_writer (p);
+      wait_queue_wake (&p->pollers);
+    }
+  lock_release (&p->read_lock);
+  return avail;
+}
+
+/* Writes up to SIZE bytes from BUFFER into P, without blocking.
+   Returns the number of bytes written, which is 0 if P is full,
+   or -1 if every read end is closed. */
+int
+pipe_write (struct pipe *p, const void *buffer_, size_t size)
+{
+  const uint8_t *buffer = buffer_;
+  size_t space, ofs, first;
+
+  lock_acquire (&p->write_lock);
+  if (p->readers == 0)
+    {
+      lock_release (&p->write_lock);
+      return -1;
+    }
+  space = PIPE_SIZE - (p->tail - p->head);
+  if (space > size)
+    space = size;
+  if (space > 0)
+    {
+      ofs = p->tail % PIPE_SIZE;
+      first = space < PIPE_SIZE - ofs ? space : PIPE_SIZE - ofs;
+      memcpy (p->buf + ofs, buffer, first);
+      memcpy (p->buf, buffer + first, space - first);
+      barrier ();
+      p->tail += space;
+
+      if (p->reader_waiting)
+        wake_reader (p);
+      wait_queue_wake (&p->pollers);
+    }
+  lock_release (&p->write_lock);
+  return space;
+}
+
+/* Waits until the read end of P has data to read, or the write
+   end if WRITER is true has room to write.  Returns true if so,
+   false if it never will: for a reader, P is empty and has no
+   write ends left open (end of file); for a writer, every read
+   end is closed.  Must not be called with a user page pinned. */
+bool
+pipe_wait (struct pipe *p, bool writer)
+{
+  bool ready;
+
+  if (writer)
+    {
+      lock_acquire (&p->write_lock);
+      while (p->tail - p->head == PIPE_SIZE && p->readers > 0)
+        {
+          p->writer_waiting = true;
+          barrier ();
+          if (p->tail - p->head < PIPE_SIZE || p->readers == 0)
+            p->writer_waiting = false;
+          else
+            sema_down (&p->writable);
+        }
+      ready = p->readers > 0;
+      lock_release (&p->write_lock);
+    }
+  else
+    {
+      lock_acquire (&p->read_lock);
+      while (p->tail == p->head && p->writers > 0)
+        {
+          p->reader_waiting = true;
+          barrier ();
+          if (p->tail != p->head || p->writers == 0)
+            p->reader_waiting = false;
+          else
+            sema_down (&p->readable);
+        }
+      ready = p->tail != p->head;
+      lock_release (&p->read_lock);
+    }
+  return ready;
+}
+
+/* Returns the poll() events that are ready on the read end of
+   P, or on the write end if WRITER is true, and stores into *WQ
+   the wait queue that is woken when they might change. */
+unsigned
+pipe_poll (struct pipe *p, bool writer, struct wait_queue **wq)
+{
+  unsigned events = 0;
+
+  *wq = &p->pollers;
+  if (writer)
+    {
+      if (p->readers == 0)
+        events |= POLLERR;
+      else if (p->tail - p->head < PIPE_SIZE)
+        events |= POLLOUT;
+    }
+  else
+    {
+      if (p->tail != p->head)
+        events |= POLLIN;
+      if (p->writers == 0)
+        events |= POLLHUP;
+    }
+  return events;
+}
+
+/* Wakes up P's reader, if it is waiting. */
+static void
+wake_reader (struct pipe *p)
+{
+  p->reader_waiting = false;
+  sema_up (&p->readable);
+}
+
+/* Wakes up P's writer, if it is waiting. */
+static void
+wake_writer (struct pipe *p)
+{
+  p->writer_waiting = false;
+  sema_up (&p->writable);
+}
@@ -0,0 +1,18 @@
+#ifndef USERPROG_PIPE_H
+#define USERPROG_PIPE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct pipe;
+struct wait_queue;
+
+struct pipe *pipe_create (void);
+void pipe_open (struct pipe *, bool writer);
+void pipe_close (struct pipe *, bool writer);
+int pipe_read (struct pipe *, void *buffer, size_t size);
+int pipe_write (struct pipe *, const void *buffer, size_t size);
+bool pipe_wait (struct pipe *, bool writer);
+unsigned pipe_poll (struct pipe *, bool writer, struct wait_queue **);
+
+#endif /* userprog/pipe.h */
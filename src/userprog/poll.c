@@ -0,0 +1,155 @@
+#include "userprog/poll.h"
+#include <debug.h>
+#include <poll.h>
+#include <round.h>
+#include "devices/input.h"
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "userprog/fd.h"
+#include "userprog/pipe.h"
+#include "userprog/process.h"
+
+/* Readiness multiplexing.
+
+   poll() first checks each object it is given and returns at
+   once if any is ready.  Otherwise, it adds an entry to the wait
+   queue of each object that can change, all naming a semaphore
+   of its own, checks the objects once more in case one became
+   ready meanwhile, and sleeps on the semaphore.  Only a change
+   in one of those objects, or the timeout's alarm, wakes it up.
+   It then takes its entries back out and starts over.
+
+   Files and the console display are always ready, so they have
+   no wait queue.  Console input is woken by input_putc(), a pipe
+   by reads, writes, and closes of either end, and a child
+   process by its exit. */
+
+static int scan (struct pollfd *, size_t nfds,
+                 struct wait_queue_entry *, struct semaphore *);
+static unsigned check (const struct pollfd *, struct wait_queue **);
+
+/* Waits until one of the NFDS objects in FDS is ready for one of
+   the events requested for it, or until TIMEOUT milliseconds
+   have passed, or forever if TIMEOUT is negative.  Sets the
+   `revents' member of each element of FDS.  Returns the number
+   of elements with nonzero `revents', which is 0 on timeout, or
+   -1 if memory is short. */
+int
+poll_wait (struct pollfd *fds, size_t nfds, int timeout)
+{
+  struct wait_queue_entry *entries;
+  struct timer_alarm alarm;
+  struct semaphore sema;
+  int ready;
+  size_t i;
+
+  ready = scan (fds, nfds, NULL, NULL);
+  if (ready > 0 || timeout == 0)
+    return ready;
+
+  entries = malloc (nfds * sizeof *entries);
+  if (entries == NULL && nfds > 0)
+    return -1;
+  for (i = 0; i < nfds; i++)
+    wait_queue_entry_init (&entries[i]);
+  sema_init (&sema, 0);
+  if (timeout > 0)
+    timer_alarm_set (&alarm, DIV_ROUND_UP ((int64_t) timeout * TIMER_FREQ,
+                                           1000), &sema);
+  else
+    alarm.expired = false;
+
+  while (ready == 0 && !alarm.expired)
+    {
+      ready = scan (fds, nfds, entries, &sema);
+      if (ready == 0)
+        sema_down (&sema);
+      for (i = 0; i < nfds; i++)
+        wait_queue_remove (&entries[i]);
+      if (ready == 0)
+        ready = scan (fds, nfds, NULL, NULL);
+    }
+
+  if (timeout > 0)
+    timer_alarm_cancel (&alarm);
+  free (entries);
+  return ready;
+}
+
+/* Checks each of the NFDS objects in FDS and sets its `revents'
+   member.  If ENTRIES is nonnull, first adds ENTRIES[i] to the
+   wait queue of FDS[i]'s object, if it has one, so that waking
+   the queue ups SEMA.  Returns the number of objects with
+   nonzero `revents'. */
+static int
+scan (struct pollfd *fds, size_t nfds,
+      struct wait_queue_entry *entries, struct semaphore *sema)
+{
+  int ready = 0;
+  size_t i;
+
+  for (i = 0; i < nfds; i++)
+    {
+      struct pollfd *pfd = &fds[i];
+      struct wait_queue *wq;
+      unsigned events = check (pfd, &wq);
+      unsigned wanted = pfd->events | POLLERR | POLLHUP | POLLNVAL;
+
+      if (entries != NULL && wq != NULL)
+        {
+          wait_queue_add (wq, &entries[i], sema);
+          events = check (pfd, &wq);
+        }
+      if (pfd->events & POLLCHILD)
+        wanted |= POLLIN;
+      pfd->revents = events & wanted;
+      if (pfd->revents != 0)
+        ready++;
+    }
+  return ready;
+}
+
+/* Returns the events that are ready on PFD's object, and stores
+   into *WQ the wait queue that is woken when they might change,
+   or a null pointer if they never will. */
+static unsigned
+check (const struct pollfd *pfd, struct wait_queue **wq)
+{
+  struct open_file *of;
+  enum intr_level old_level;
+  bool empty;
+
+  *wq = NULL;
+  if (pfd->events & POLLCHILD)
+    return process_poll_child (pfd->fd, wq);
+  if (pfd->fd < 0)
+    return 0;
+
+  of = fd_get (pfd->fd);
+  if (of == NULL)
+    return POLLNVAL;
+  switch (of->type)
+    {
+    case FD_CONSOLE_IN:
+      *wq = input_wait_queue ();
+      old_level = intr_disable ();
+      empty = input_empty ();
+      intr_set_level (old_level);
+      return empty ? 0 : POLLIN;
+
+    case FD_CONSOLE_OUT:
+      return POLLOUT;
+
+    case FD_FILE:
+      return POLLIN | POLLOUT;
+
+    case FD_PIPE_READ:
+      return pipe_poll (of->pipe, false, wq);
+
+    case FD_PIPE_WRITE:
+      return pipe_poll (of->pipe, true, wq);
+    }
+  NOT_REACHED ();
+}
@@ -1,68 +1,164 @@
 #include "userprog/process.h"
 #include <debug.h>
 #include <inttypes.h>
+#include <poll.h>
 #include <round.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "userprog/fd.h"
 #include "userprog/gdt.h"
+#include "userprog/ipc.h"
 #include "userprog/pagedir.h"
+#include "userprog/ring.h"
+#include "userprog/shm.h"
 #include "userprog/tss.h"
+#include "userprog/uaccess.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#include "vm/readahead.h"
+#endif
+
+/* A child process's exit status, shared between the child and
+   its parent, either of which may exit first.  The last one to
+   let go of it frees it. */
+struct child
+  {
+    tid_t tid;                  /* Child's thread id. */
+    int exit_status;            /* -1 unless the child calls exit(). */
+    struct semaphore exited;    /* Upped when the child exits. */
+    bool has_exited;            /* Has the child exited? */
+    struct wait_queue pollers;  /* Woken when the child exits. */
+    int ref_cnt;                /* 2 while both are around, then 1. */
+    struct lock lock;           /* Protects ref_cnt. */
+    struct list_elem elem;      /* Element in parent's `children'. */
+  };
+
+/* Passed from a process calling exec() to its child. */
+struct exec_info
+  {
+    char *cmd_line;             /* Command line, in its own page. */
+    struct thread *parent;      /* Process calling exec(). */
+    struct child *child;        /* Child's exit status. */
+    struct semaphore loaded;    /* Upped when the child has loaded. */
+    bool success;               /* Did the child load? */
+  };
+
+/* Passed from a process calling fork() to its child. */
+struct fork_info
+  {
+    struct thread *parent;      /* Forking process. */
+    struct child *child;        /* Child's exit status. */
+    struct intr_frame if_;      /* Parent's user registers. */
+    struct semaphore done;      /* Upped when the child is set up. */
+    bool success;               /* Did the child set up? */
+  };
 
 static thread_func start_process NO_RETURN;
+static thread_func start_fork NO_RETURN;
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
-
-/* Starts a new thread running a user program loaded from
-   FILENAME.  The new thread may be scheduled (and may even exit)
-   before process_execute() returns.  Returns the new process's
-   thread id, or TID_ERROR if the thread cannot be created. */
+static int split_words (char *cmd_line, size_t *size);
+static bool push_arguments (const char *words, size_t size, int argc,
+                            void **esp);
+static bool copy_address_space (struct thread *parent);
+static struct child *child_create (void);
+static void child_release (struct child *);
+
+/* Starts a new thread running a user program loaded from the
+   first word of CMD_LINE, passing it the words of CMD_LINE as
+   its arguments.  Waits for the program to load.  Returns the
+   new process's thread id, or TID_ERROR if the thread cannot be
+   created or the program cannot be loaded. */
 tid_t
-process_execute (const char *file_name) 
+process_execute (const char *cmd_line) 
 {
-  char *fn_copy;
+  struct exec_info info;
+  char name[sizeof ((struct thread *) 0)->name];
   tid_t tid;
 
-  /* Make a copy of FILE_NAME.
+  /* Make a copy of CMD_LINE.
      Otherwise there's a race between the caller and load(). */
-  fn_copy = palloc_get_page (0);
-  if (fn_copy == NULL)
+  info.cmd_line = palloc_get_page (0);
+  if (info.cmd_line == NULL)
     return TID_ERROR;
-  strlcpy (fn_copy, file_name, PGSIZE);
+  strlcpy (info.cmd_line, cmd_line, PGSIZE);
+  info.parent = thread_current ();
+  info.child = child_create ();
+  if (info.child == NULL)
+    {
+      palloc_free_page (info.cmd_line);
+      return TID_ERROR;
+    }
+  sema_init (&info.loaded, 0);
+  info.success = false;
 
-  /* Create a new thread to execute FILE_NAME. */
-  tid = thread_create (file_name, PRI_DEFAULT, start_process, fn_copy);
+  /* Name the thread after the program. */
+  cmd_line += strspn (cmd_line, " ");
+  strlcpy (name, cmd_line, sizeof name);
+  name[strcspn (name, " ")] = '\0';
+
+  /* Create a new thread to execute CMD_LINE. */
+  tid = thread_create (name, PRI_DEFAULT, start_process, &info);
   if (tid == TID_ERROR)
-    palloc_free_page (fn_copy); 
+    {
+      palloc_free_page (info.cmd_line);
+      free (info.child);
+      return TID_ERROR;
+    }
+  sema_down (&info.loaded);
+  if (!info.success)
+    {
+      child_release (info.child);
+      return TID_ERROR;
+    }
+  info.child->tid = tid;
+  list_push_back (&thread_current ()->children, &info.child->elem);
   return tid;
 }
 
 /* A thread function that loads a user process and starts it
    running. */
 static void
-start_process (void *file_name_)
+start_process (void *info_)
 {
-  char *file_name = file_name_;
+  struct exec_info *info = info_;
+  struct thread *t = thread_current ();
+  char *cmd_line = info->cmd_line;
   struct intr_frame if_;
+  size_t size;
+  int argc;
   bool success;
 
+  t->child = info->child;
+
   /* Initialize interrupt frame and load executable. */
   memset (&if_, 0, sizeof if_);
   if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
-  success = load (file_name, &if_.eip, &if_.esp);
-
-  /* If load failed, quit. */
-  palloc_free_page (file_name);
+  argc = split_words (cmd_line, &size);
+  success = (argc > 0
+             && fd_table_init (info->parent)
+             && load (cmd_line, &if_.eip, &if_.esp)
+             && push_arguments (cmd_line, size, argc, &if_.esp));
+
+  /* INFO lives on the parent's stack, so we can't touch it once
+     the parent wakes up.  If load failed, quit. */
+  palloc_free_page (cmd_line);
+  info->success = success;
+  sema_up (&info->loaded);
   if (!success) 
     thread_exit ();
 
@@ -76,21 +172,207 @@ start_process (void *file_name_)
   NOT_REACHED ();
 }
 
+/* Creates a child of the running process, as by fork(), that
+   resumes running in user mode with the registers in IF_, except
+   that its fork() returns 0.  The child starts out with a
+   copy-on-write copy of the running process's address space.
+   Returns the child's thread id, or TID_ERROR if the child
+   cannot be created. */
+tid_t
+process_fork (const struct intr_frame *if_)
+{
+  struct thread *cur = thread_current ();
+  struct fork_info info;
+  tid_t tid;
+
+  info.parent = cur;
+  info.child = child_create ();
+  if (info.child == NULL)
+    return TID_ERROR;
+  info.if_ = *if_;
+  sema_init (&info.done, 0);
+  info.success = false;
+
+  /* Wait for the child to copy our address space, which must not
+     change in the meantime. */
+  tid = thread_create (cur->name, PRI_DEFAULT, start_fork, &info);
+  if (tid == TID_ERROR)
+    {
+      free (info.child);
+      return TID_ERROR;
+    }
+  sema_down (&info.done);
+  if (!info.success)
+    {
+      child_release (info.child);
+      return TID_ERROR;
+    }
+  info.child->tid = tid;
+  list_push_back (&cur->children, &info.child->elem);
+  return tid;
+}
+
+/* A thread function that sets up a child process created by
+   process_fork() and starts it running. */
+static void
+start_fork (void *info_)
+{
+  struct fork_info *info = info_;
+  struct intr_frame if_ = info->if_;
+  bool success;
+
+  /* INFO lives on the parent's stack, so we can't touch it once
+     the parent wakes up. */
+  thread_current ()->child = info->child;
+  success = info->success = (copy_address_space (info->parent)
+                             && fd_table_copy (info->parent));
+  sema_up (&info->done);
+  if (!success)
+    thread_exit ();
+
+  if_.eax = 0;
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+
+/* Returns a new exit status record for a child process that is
+   about to be created, with a reference for the parent and one
+   for the child, or a null pointer if memory is short. */
+static struct child *
+child_create (void)
+{
+  struct child *c = malloc (sizeof *c);
+
+  if (c != NULL)
+    {
+      c->tid = TID_ERROR;
+      c->exit_status = -1;
+      sema_init (&c->exited, 0);
+      c->has_exited = false;
+      wait_queue_init (&c->pollers);
+      c->ref_cnt = 2;
+      lock_init (&c->lock);
+    }
+  return c;
+}
+
+/* Drops a reference to child exit status record C, freeing it
+   if it was the last one. */
+static void
+child_release (struct child *c)
+{
+  bool last;
+
+  lock_acquire (&c->lock);
+  last = --c->ref_cnt == 0;
+  lock_release (&c->lock);
+  if (last)
+    free (c);
+}
+
+/* Gives the running thread, which was just created by
+   process_fork(), a copy of PARENT's address space, sharing
+   PARENT's shared memory segments, and reopens PARENT's
+   executable for it.  Returns true if successful,
+   false otherwise. */
+static bool
+copy_address_space (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+
+  t->pagedir = pagedir_create ();
+  if (t->pagedir == NULL)
+    return false;
+  process_activate ();
+
+  if (parent->exec_file != NULL)
+    {
+      lock_acquire (&filesys_lock);
+      t->exec_file = file_reopen (parent->exec_file);
+      if (t->exec_file != NULL)
+        file_deny_write (t->exec_file);
+      lock_release (&filesys_lock);
+      if (t->exec_file == NULL)
+        return false;
+    }
+
+#ifdef VM
+  if (!page_table_init () || !page_table_copy (parent))
+    return false;
+#else
+  if (!pagedir_copy (t->pagedir, parent->pagedir))
+    return false;
+#endif
+  return shm_copy (parent);
+}
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
    child of the calling process, or if process_wait() has already
    been successfully called for the given TID, returns -1
-   immediately, without waiting.
-
-   This function will be implemented in problem 2-2.  For now, it
-   does nothing. */
+   immediately, without waiting. */
 int
-process_wait (tid_t child_tid UNUSED) 
+process_wait (tid_t child_tid) 
 {
+  struct thread *cur = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&cur->children); e != list_end (&cur->children);
+       e = list_next (e))
+    {
+      struct child *c = list_entry (e, struct child, elem);
+      if (c->tid == child_tid)
+        {
+          int status;
+
+          list_remove (&c->elem);
+          sema_down (&c->exited);
+          status = c->exit_status;
+          child_release (c);
+          return status;
+        }
+    }
   return -1;
 }
 
+/* Returns POLLIN if child process TID of the running process
+   has exited, 0 if it is still running, or POLLNVAL if TID is not
+   a child that the running process can wait for.  Stores into
+   *WQ the wait queue that is woken when the child exits, or a
+   null pointer for POLLNVAL. */
+unsigned
+process_poll_child (tid_t child_tid, struct wait_queue **wq)
+{
+  struct thread *cur = thread_current ();
+  struct list_elem *e;
+
+  *wq = NULL;
+  for (e = list_begin (&cur->children); e != list_end (&cur->children);
+       e = list_next (e))
+    {
+      struct child *c = list_entry (e, struct child, elem);
+      if (c->tid == child_tid)
+        {
+          *wq = &c->pollers;
+          return c->has_exited ? POLLIN : 0;
+        }
+    }
+  return POLLNVAL;
+}
+
+/* Terminates the running process with exit status STATUS, as
+   reported to its parent by process_wait(). */
+void
+process_terminate (int status)
+{
+  struct thread *cur = thread_current ();
+
+  if (cur->child != NULL)
+    cur->child->exit_status = status;
+  thread_exit ();
+}
+
 /* Free the current process's resources. */
 void
 process_exit (void)
@@ -98,6 +380,30 @@ process_exit (void)
   struct thread *cur = thread_current ();
   uint32_t *pd;
 
+  if (cur->child != NULL)
+    printf ("%s: exit(%d)\n", cur->name, cur->child->exit_status);
+
+  /* Our children's exit statuses are of no more use to anyone. */
+  while (!list_empty (&cur->children))
+    child_release (list_entry (list_pop_front (&cur->children),
+                               struct child, elem));
+
+  /* Let the workers finish with our ring before our files and
+     memory go away. */
+  ring_destroy ();
+
+  /* Unmap shared memory, which is not ours to free, before our
+     page directory goes away. */
+  shm_exit ();
+
+#ifdef VM
+  /* Write back memory-mapped files and forget about the
+     process's pages before its page directory goes away. */
+  mmap_unmap_all ();
+  page_table_destroy ();
+  readahead_exit ();
+#endif
+
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
   pd = cur->pagedir;
@@ -114,6 +420,30 @@ process_exit (void)
       pagedir_activate (NULL);
       pagedir_destroy (pd);
     }
+
+  /* Fail any IPC calls still waiting for us. */
+  ipc_exit ();
+
+  /* Close the executable, allowing writes to it again, and any
+     other files the process left open. */
+  if (cur->exec_file != NULL) 
+    {
+      lock_acquire (&filesys_lock);
+      file_close (cur->exec_file);
+      lock_release (&filesys_lock);
+      cur->exec_file = NULL;
+    }
+  fd_table_destroy ();
+
+  /* Tell our parent, if it is still waiting, that we are done. */
+  if (cur->child != NULL)
+    {
+      cur->child->has_exited = true;
+      sema_up (&cur->child->exited);
+      wait_queue_wake (&cur->child->pollers);
+      child_release (cur->child);
+      cur->child = NULL;
+    }
 }
 
 /* Sets up the CPU for running user code in the current
@@ -215,11 +545,17 @@ load (const char *file_name, void (**eip) (void), void **esp)
   bool success = false;
   int i;
 
+  lock_acquire (&filesys_lock);
+
   /* Allocate and activate page directory. */
   t->pagedir = pagedir_create ();
   if (t->pagedir == NULL) 
     goto done;
   process_activate ();
+#ifdef VM
+  if (!page_table_init ())
+    goto done;
+#endif
 
   /* Open executable file. */
   file = filesys_open (file_name);
@@ -311,14 +647,102 @@ load (const char *file_name, void (**eip) (void), void **esp)
   success = true;
 
  done:
-  /* We arrive here whether the load is successful or not. */
-  file_close (file);
+  /* We arrive here whether the load is successful or not.
+     A successfully loaded executable stays open while the
+     process runs, because its pages may not have been read yet,
+     and it must not be modified in the meantime. */
+  if (success) 
+    {
+      t->exec_file = file;
+      file_deny_write (file);
+    }
+  else
+    file_close (file);
+  lock_release (&filesys_lock);
   return success;
 }
 
+/* Splits CMD_LINE into words separated by spaces and packs them
+   together at the start of CMD_LINE, each followed by a null
+   terminator.  Returns the number of words and sets *SIZE to
+   the number of bytes they occupy. */
+static int
+split_words (char *cmd_line, size_t *size)
+{
+  char *dst = cmd_line;
+  char *word, *save_ptr;
+  int argc = 0;
+
+  for (word = strtok_r (cmd_line, " ", &save_ptr); word != NULL;
+       word = strtok_r (NULL, " ", &save_ptr))
+    {
+      size_t len = strlen (word) + 1;
+
+      memmove (dst, word, len);
+      dst += len;
+      argc++;
+    }
+  *size = dst - cmd_line;
+  return argc;
+}
+
+/* Pushes the ARGC packed words in the SIZE bytes at WORDS onto
+   the user stack at *ESP, as the arguments of the program's
+   main() function, and updates *ESP.  The stack frame is built
+   in kernel memory and copied out in one piece, so it has to fit
+   in the stack's first page.  Returns true if successful, false
+   if there are too many arguments or memory is short. */
+static bool
+push_arguments (const char *words, size_t size, int argc, void **esp)
+{
+  size_t frame_size = (sizeof (void *)             /* Return address. */
+                       + sizeof (int)              /* argc. */
+                       + sizeof (char **)          /* argv. */
+                       + (argc + 1) * sizeof (char *) /* argv[]. */
+                       + ROUND_UP (size, sizeof (char *)));
+  uint8_t *frame, *ustack, *word;
+  uint32_t *sp;
+  char **argv;
+  bool success;
+  int i;
+
+  ASSERT (*esp == PHYS_BASE);
+
+  if (frame_size > PGSIZE)
+    return false;
+  frame = calloc (1, frame_size);
+  if (frame == NULL)
+    return false;
+
+  /* FRAME will end up at USTACK, so a pointer to byte P of FRAME
+     becomes USTACK + (P - FRAME) in user space. */
+  ustack = (uint8_t *) PHYS_BASE - frame_size;
+  sp = (uint32_t *) frame;
+  argv = (char **) (sp + 3);
+  word = frame + frame_size - size;
+  memcpy (word, words, size);
+  for (i = 0; i < argc; i++)
+    {
+      argv[i] = (char *) (ustack + (word - frame));
+      word += strlen ((char *) word) + 1;
+    }
+  argv[argc] = NULL;
+  sp[0] = 0;
+  sp[1] = argc;
+  sp[2] = (uint32_t) (ustack + ((uint8_t *) argv - frame));
+
+  success = copy_to_user (ustack, frame, frame_size);
+  free (frame);
+  if (success)
+    *esp = ustack;
+  return success;
+}
+
 /* load() helpers. */
 
+#ifndef VM
 static bool install_page (void *upage, void *kpage, bool writable);
+#endif
 
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -377,6 +801,11 @@ validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
    The pages initialized by this function must be writable by the
    user process if WRITABLE is true, read-only otherwise.
 
+   With virtual memory, the pages are only recorded in the
+   supplemental page table here.  Each one is read in when the
+   process first accesses it, so FILE must stay open until the
+   process exits.
+
    Return true if successful, false if a memory allocation error
    or disk read error occurs. */
 static bool
@@ -387,7 +816,9 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
 
+#ifndef VM
   file_seek (file, ofs);
+#endif
   while (read_bytes > 0 || zero_bytes > 0) 
     {
       /* Calculate how to fill this page.
@@ -396,6 +827,14 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
       size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
+#ifdef VM
+      /* Record the page for loading on first access. */
+      if (page_read_bytes > 0
+          ? page_add_file (upage, file, ofs, page_read_bytes, writable) == NULL
+          : page_add_zero (upage, writable) == NULL)
+        return false;
+      ofs += page_read_bytes;
+#else
       /* Get a page of memory. */
       uint8_t *kpage = palloc_get_page (PAL_USER);
       if (kpage == NULL)
@@ -415,6 +854,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
           palloc_free_page (kpage);
           return false; 
         }
+#endif
 
       /* Advance. */
       read_bytes -= page_read_bytes;
@@ -425,10 +865,18 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 }
 
 /* Create a minimal stack by mapping a zeroed page at the top of
-   user virtual memory. */
+   user virtual memory.  With virtual memory, the page is only
+   recorded, to be allocated on first access, and the stack grows
+   on demand from there. */
 static bool
 setup_stack (void **esp) 
 {
+#ifdef VM
+  if (page_add_zero (((uint8_t *) PHYS_BASE) - PGSIZE, true) == NULL)
+    return false;
+  *esp = PHYS_BASE;
+  return true;
+#else
   uint8_t *kpage;
   bool success = false;
 
@@ -442,8 +890,10 @@ setup_stack (void **esp)
         palloc_free_page (kpage);
     }
   return success;
+#endif
 }
 
+#ifndef VM
 /* Adds a mapping from user virtual address UPAGE to kernel
    virtual address KPAGE to the page table.
    If WRITABLE is true, the user process may modify the page;
@@ -463,3 +913,4 @@ install_page (void *upage, void *kpage, bool writable)
   return (pagedir_get_page (t->pagedir, upage) == NULL
           && pagedir_set_page (t->pagedir, upage, kpage, writable));
 }
+#endif
@@ -3,8 +3,14 @@
 
 #include "threads/thread.h"
 
-tid_t process_execute (const char *file_name);
+struct intr_frame;
+struct wait_queue;
+
+tid_t process_execute (const char *cmd_line);
+tid_t process_fork (const struct intr_frame *);
 int process_wait (tid_t);
+unsigned process_poll_child (tid_t, struct wait_queue **);
+void process_terminate (int status) NO_RETURN;
 void process_exit (void);
 void process_activate (void);
 
@@ -0,0 +1,455 @@
+#include "userprog/ring.h"
+#include <debug.h>
+#include <list.h>
+#include <ring.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <syscall-nr.h>
+#include "devices/input.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/fd.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "userprog/syscall.h"
+#include "userprog/uaccess.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
+
+/* Submission and completion rings.
+
+   See lib/ring.h for the interface seen by processes.  The ring
+   page is allocated from the kernel pool and mapped into the
+   process, so the kernel reaches it at its kernel address from
+   any thread, without faulting.  The kernel never trusts the
+   copies of its own indexes in the shared page, only those in
+   `struct ring_ctx'.
+
+   Reads and writes are handed to a small pool of worker
+   threads.  A worker cannot touch the process's memory, which is
+   not mapped in its page directory, so the data goes through a
+   kernel bounce buffer: ring_enter() copies in the data for a
+   write when it submits the request, and copies out the data
+   for a read when it posts the completion.  Completions are
+   therefore posted only while the process is in ring_enter().
+
+   A ring's requests are served by at most one worker at a time,
+   in submission order.  Opens, closes, and seeks run in the
+   process itself, as ordinary system calls, after waiting for
+   the requests ahead of them to finish. */
+
+/* Number of worker threads. */
+#define RING_WORKERS 2
+
+/* Kernel state for a process's ring. */
+struct ring_ctx
+  {
+    struct ring *ring;          /* Shared page, at its kernel address. */
+    void *uaddr;                /* Shared page's user address. */
+    unsigned sq_head;           /* Next submission entry to take. */
+    unsigned cq_tail;           /* Next completion entry to fill. */
+    unsigned inflight;          /* Submitted but not yet posted. */
+
+    /* Shared with the workers, protected by `lock'. */
+    struct lock lock;
+    struct condition done;      /* Signaled when a request finishes. */
+    struct list pending;        /* Requests waiting for a worker. */
+    struct list finished;       /* Requests waiting to be posted. */
+    bool busy;                  /* In work_queue or being served? */
+    struct list_elem elem;      /* Element in work_queue. */
+  };
+
+/* An asynchronous read or write. */
+struct ring_req
+  {
+    struct ring_sqe sqe;        /* Copy of submission entry. */
+    struct file *file;          /* File, or null for the console. */
+    uint8_t *buf;               /* Bounce buffer, one page. */
+    int result;                 /* Result, once finished. */
+    struct list_elem elem;      /* In `pending' or `finished'. */
+  };
+
+/* Rings with requests for the workers, protected by work_lock. */
+static struct list work_queue;
+static struct lock work_lock;
+static struct condition work_cond;
+
+/* True once the workers have been started, on the first call to
+   ring_setup(), protected by work_lock. */
+static bool workers_started;
+
+static thread_func worker NO_RETURN;
+static void start_workers (void);
+static bool submit (struct ring_ctx *);
+static void reap (struct ring_ctx *, unsigned min_complete);
+static void wait_idle (struct ring_ctx *);
+static void post (struct ring_ctx *, unsigned user_data, int result);
+static void free_request (struct ring_req *);
+
+/* Initializes the ring system. */
+void
+ring_init (void)
+{
+  list_init (&work_queue);
+  lock_init (&work_lock);
+  cond_init (&work_cond);
+}
+
+/* Maps a new, empty ring at page-aligned user address UADDR in
+   the running process.  Returns true if successful, false if
+   the process already has a ring, UADDR is misaligned or already
+   in use, or memory allocation fails. */
+bool
+ring_setup (void *uaddr)
+{
+  struct thread *t = thread_current ();
+  struct ring_ctx *ctx;
+
+  ASSERT (sizeof (struct ring) <= PGSIZE);
+
+  if (t->ring != NULL || uaddr == NULL || pg_ofs (uaddr) != 0
+      || !is_user_vaddr (uaddr)
+      || pagedir_get_phys (t->pagedir, uaddr) != 0)
+    return false;
+#ifdef VM
+  if (page_lookup (uaddr) != NULL)
+    return false;
+#endif
+
+  start_workers ();
+
+  ctx = malloc (sizeof *ctx);
+  if (ctx == NULL)
+    return false;
+  ctx->ring = palloc_get_page (PAL_ZERO);
+  if (ctx->ring == NULL)
+    {
+      free (ctx);
+      return false;
+    }
+  if (!pagedir_set_page (t->pagedir, uaddr, ctx->ring, true))
+    {
+      palloc_free_page (ctx->ring);
+      free (ctx);
+      return false;
+    }
+  ctx->uaddr = uaddr;
+  ctx->sq_head = ctx->cq_tail = ctx->inflight = 0;
+  lock_init (&ctx->lock);
+  cond_init (&ctx->done);
+  list_init (&ctx->pending);
+  list_init (&ctx->finished);
+  ctx->busy = false;
+  t->ring = ctx;
+  return true;
+}
+
+/* Submits up to TO_SUBMIT requests from the running process's
+   ring, then waits until at least MIN_COMPLETE completions are
+   waiting to be consumed or nothing remains in flight.  Returns
+   the number of requests submitted, which is less than
+   TO_SUBMIT if the submission ring runs dry or the completion
+   ring could not hold any more results, or -1 if the process has
+   no ring. */
+int
+ring_enter (unsigned to_submit, unsigned min_complete)
+{
+  struct ring_ctx *ctx = thread_current ()->ring;
+  unsigned submitted;
+
+  if (ctx == NULL)
+    return -1;
+
+  for (submitted = 0; submitted < to_submit; submitted++)
+    if (!submit (ctx))
+      break;
+  reap (ctx, min_complete);
+  return submitted;
+}
+
+/* Waits until the workers have finished every request submitted
+   through the running process's ring.  Called before closing a
+   file, which a request might be using. */
+void
+ring_wait_idle (void)
+{
+  struct ring_ctx *ctx = thread_current ()->ring;
+
+  if (ctx != NULL)
+    wait_idle (ctx);
+}
+
+/* Tears down the running process's ring, if it has one, after
+   waiting for its requests to finish.  Results not yet posted
+   are discarded. */
+void
+ring_destroy (void)
+{
+  struct thread *t = thread_current ();
+  struct ring_ctx *ctx = t->ring;
+
+  if (ctx == NULL)
+    return;
+
+  wait_idle (ctx);
+  while (!list_empty (&ctx->finished))
+    free_request (list_entry (list_pop_front (&ctx->finished),
+                              struct ring_req, elem));
+
+  /* The process may have unmapped the ring page, by mapping
+     something else over it, so only unmap it if it is still
+     there. */
+  if (pagedir_get_phys (t->pagedir, ctx->uaddr) == vtop (ctx->ring))
+    pagedir_clear_page (t->pagedir, ctx->uaddr);
+  palloc_free_page (ctx->ring);
+  free (ctx);
+  t->ring = NULL;
+}
+
+/* Starts the worker threads, if they are not running yet. */
+static void
+start_workers (void)
+{
+  int i;
+
+  lock_acquire (&work_lock);
+  if (!workers_started)
+    {
+      for (i = 0; i < RING_WORKERS; i++)
+        {
+          char name[16];
+          snprintf (name, sizeof name, "ring%d", i);
+          thread_create (name, PRI_DEFAULT, worker, NULL);
+        }
+      workers_started = true;
+    }
+  lock_release (&work_lock);
+}
+
+/* Runs requests for whichever rings need service.  Each ring
+   gets one request per turn, then goes to the back of the
+   queue if it has more, so that one process can't keep a worker
+   to itself. */
+static void
+worker (void *aux UNUSED)
+{
+  for (;;)
+    {
+      struct ring_ctx *ctx;
+      struct ring_req *req;
+      const struct ring_sqe *sqe;
+
+      lock_acquire (&work_lock);
+      while (list_empty (&work_queue))
+        cond_wait (&work_cond, &work_lock);
+      ctx = list_entry (list_pop_front (&work_queue),
+                        struct ring_ctx, elem);
+      lock_release (&work_lock);
+
+      lock_acquire (&ctx->lock);
+      req = list_entry (list_pop_front (&ctx->pending),
+                        struct ring_req, elem);
+      lock_release (&ctx->lock);
+
+      sqe = &req->sqe;
+      if (sqe->op == RING_READ && req->file == NULL)
+        {
+          for (req->result = 0; (unsigned) req->result < sqe->size;
+               req->result++)
+            req->buf[req->result] = input_getc ();
+        }
+      else if (sqe->op == RING_WRITE && req->file == NULL)
+        {
+          putbuf ((const char *) req->buf, sqe->size);
+          req->result = sqe->size;
+        }
+      else
+        {
+          struct inode *inode = file_get_inode (req->file);
+
+          /* Don't land in the middle of a read or write system
+             call on the same file; see transfer(). */
+          inode_lock (inode);
+          lock_acquire (&filesys_lock);
+          if (sqe->op == RING_READ)
+            req->result = file_read (req->file, req->buf, sqe->size);
+          else
+            req->result = file_write (req->file, req->buf, sqe->size);
+          lock_release (&filesys_lock);
+          inode_unlock (inode);
+        }
+
+      lock_acquire (&ctx->lock);
+      list_push_back (&ctx->finished, &req->elem);
+      if (!list_empty (&ctx->pending))
+        {
+          lock_acquire (&work_lock);
+          list_push_back (&work_queue, &ctx->elem);
+          cond_signal (&work_cond, &work_lock);
+          lock_release (&work_lock);
+        }
+      else
+        ctx->busy = false;
+      cond_signal (&ctx->done, &ctx->lock);
+      lock_release (&ctx->lock);
+    }
+}
+
+/* Takes the next entry from CTX's submission ring and starts it
+   or, for a request that runs synchronously, runs it.  Returns
+   false without taking an entry if the submission ring is empty
+   or the completion ring might not have room for its result. */
+static bool
+submit (struct ring_ctx *ctx)
+{
+  struct ring *ring = ctx->ring;
+  struct ring_sqe sqe;
+  struct ring_req *req;
+  struct open_file *of;
+  uint32_t args[2];
+
+  if (ctx->sq_head == ring->sq_tail
+      || ctx->inflight + (ctx->cq_tail - ring->cq_head) >= RING_ENTRIES)
+    return false;
+  barrier ();
+  sqe = ring->sq[ctx->sq_head++ % RING_ENTRIES];
+  ring->sq_head = ctx->sq_head;
+
+  switch (sqe.op)
+    {
+    case RING_OPEN:
+    case RING_CLOSE:
+    case RING_SEEK:
+      wait_idle (ctx);
+      reap (ctx, 0);
+      args[0] = sqe.op == RING_OPEN ? (uint32_t) sqe.buf : (uint32_t) sqe.fd;
+      args[1] = sqe.size;
+      post (ctx, sqe.user_data,
+            syscall_invoke (sqe.op == RING_OPEN ? SYS_OPEN
+                            : sqe.op == RING_CLOSE ? SYS_CLOSE : SYS_SEEK,
+                            args));
+      return true;
+
+    case RING_READ:
+    case RING_WRITE:
+      break;
+
+    default:
+      post (ctx, sqe.user_data, -1);
+      return true;
+    }
+
+  req = malloc (sizeof *req);
+  if (req == NULL)
+    {
+      post (ctx, sqe.user_data, -1);
+      return true;
+    }
+  req->sqe = sqe;
+  if (sqe.size > RING_IO_MAX)
+    req->sqe.size = RING_IO_MAX;
+  req->buf = palloc_get_page (0);
+  of = fd_get (sqe.fd);
+  if (req->buf == NULL || of == NULL
+      || (of->type != FD_FILE
+          && of->type != (sqe.op == RING_READ
+                          ? FD_CONSOLE_IN : FD_CONSOLE_OUT)))
+    {
+      free_request (req);
+      post (ctx, sqe.user_data, -1);
+      return true;
+    }
+  req->file = of->file;
+  if (sqe.op == RING_WRITE
+      && !copy_from_user (req->buf, sqe.buf, req->sqe.size))
+    {
+      free_request (req);
+      process_terminate (-1);
+    }
+
+  ctx->inflight++;
+  lock_acquire (&ctx->lock);
+  list_push_back (&ctx->pending, &req->elem);
+  if (!ctx->busy)
+    {
+      ctx->busy = true;
+      lock_acquire (&work_lock);
+      list_push_back (&work_queue, &ctx->elem);
+      cond_signal (&work_cond, &work_lock);
+      lock_release (&work_lock);
+    }
+  lock_release (&ctx->lock);
+  return true;
+}
+
+/* Posts the results of CTX's finished requests, then waits for
+   more until MIN_COMPLETE completions are waiting to be
+   consumed or none are in flight. */
+static void
+reap (struct ring_ctx *ctx, unsigned min_complete)
+{
+  lock_acquire (&ctx->lock);
+  for (;;)
+    {
+      while (!list_empty (&ctx->finished))
+        {
+          struct ring_req *req = list_entry (list_pop_front (&ctx->finished),
+                                             struct ring_req, elem);
+          lock_release (&ctx->lock);
+
+          ctx->inflight--;
+          if (req->sqe.op == RING_READ && req->result > 0
+              && !copy_to_user (req->sqe.buf, req->buf, req->result))
+            {
+              free_request (req);
+              process_terminate (-1);
+            }
+          post (ctx, req->sqe.user_data, req->result);
+          free_request (req);
+
+          lock_acquire (&ctx->lock);
+        }
+      if (ctx->inflight == 0
+          || ctx->cq_tail - ctx->ring->cq_head >= min_complete)
+        break;
+      cond_wait (&ctx->done, &ctx->lock);
+    }
+  lock_release (&ctx->lock);
+}
+
+/* Waits until no worker has any of CTX's requests. */
+static void
+wait_idle (struct ring_ctx *ctx)
+{
+  lock_acquire (&ctx->lock);
+  while (ctx->busy)
+    cond_wait (&ctx->done, &ctx->lock);
+  lock_release (&ctx->lock);
+}
+
+/* Fills in the next entry in CTX's completion ring. */
+static void
+post (struct ring_ctx *ctx, unsigned user_data, int result)
+{
+  struct ring_cqe *cqe = &ctx->ring->cq[ctx->cq_tail++ % RING_ENTRIES];
+
+  cqe->user_data = user_data;
+  cqe->result = result;
+  barrier ();
+  ctx->ring->cq_tail = ctx->cq_tail;
+}
+
+/* Frees REQ and its bounce buffer. */
+static void
+free_request (struct ring_req *req)
+{
+  palloc_free_page (req->buf);
+  free (req);
+}
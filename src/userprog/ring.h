@@ -0,0 +1,12 @@
+#ifndef USERPROG_RING_H
+#define USERPROG_RING_H
+
+#include <stdbool.h>
+
+void ring_init (void);
+bool ring_setup (void *uaddr);
+int ring_enter (unsigned to_submit, unsigned min_complete);
+void ring_wait_idle (void);
+void ring_destroy (void);
+
+#endif /* userprog/ring.h */
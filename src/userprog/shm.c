@@ -0,0 +1,369 @@
+#include "userprog/shm.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
+
+/* Shared anonymous memory.
+
+   A segment is a run of zeroed pages, allocated when it is
+   created, that any process knowing its handle may map into its
+   address space.  Each page is entered directly into the page
+   directory of every process that maps it, with
+   pagedir_set_page(), so all of them reach the same frames
+   without ever faulting.  The pages are not in the supplemental
+   page table, so they are never evicted.
+
+   Every process keeps a list of its references to segments: one
+   for each segment it created, and one for each place it has
+   mapped one.  fork() gives the child a copy of each of them and
+   exit drops them all.  A segment is freed when its last
+   reference goes away, so a handle stays good only as long as
+   some process still holds the segment.
+
+   pagedir_destroy() frees every page it finds, and
+   pagedir_copy() gives a child private copies of them, so a
+   process's segments must be unmapped before its page directory
+   goes away, and a child's private copies must be replaced by
+   the shared pages after fork(). */
+
+/* A shared memory segment. */
+struct shm_segment
+  {
+    int handle;                 /* Handle. */
+    size_t page_cnt;            /* Number of pages. */
+    void **pages;               /* Kernel address of each page. */
+    int ref_cnt;                /* References, protected by shm_lock. */
+    struct list_elem elem;      /* Element in `segments'. */
+  };
+
+/* A process's reference to a segment. */
+struct shm_ref
+  {
+    struct shm_segment *segment; /* Segment. */
+    void *uaddr;                /* Where it is mapped, or null. */
+    struct list_elem elem;      /* Element in thread's `shm_refs'. */
+  };
+
+/* All segments, and the next handle to assign, protected by
+   shm_lock. */
+static struct list segments;
+static int next_handle;
+static struct lock shm_lock;
+
+static struct shm_segment *get_segment (int handle);
+static void put_segment (struct shm_segment *);
+static void free_segment (struct shm_segment *);
+static bool range_is_free (uint32_t *pd, void *uaddr, size_t page_cnt);
+static bool map_segment (uint32_t *pd, struct shm_segment *, void *uaddr);
+
+/* Initializes the shared memory subsystem. */
+void
+shm_init (void)
+{
+  list_init (&segments);
+  next_handle = 0;
+  lock_init (&shm_lock);
+}
+
+/* Creates a new segment of SIZE bytes, rounded up to a whole
+   number of pages and filled with zeros, held by the running
+   process.  Returns its handle, or -1 if SIZE is 0 or memory is
+   short. */
+int
+shm_create (size_t size)
+{
+  struct shm_segment *seg;
+  struct shm_ref *ref;
+  size_t i;
+
+  if (size == 0 || size > (uintptr_t) PHYS_BASE)
+    return -1;
+
+  ref = malloc (sizeof *ref);
+  if (ref == NULL)
+    return -1;
+  seg = malloc (sizeof *seg);
+  if (seg == NULL)
+    {
+      free (ref);
+      return -1;
+    }
+  seg->page_cnt = DIV_ROUND_UP (size, PGSIZE);
+  seg->pages = calloc (seg->page_cnt, sizeof *seg->pages);
+  if (seg->pages == NULL)
+    {
+      free (seg);
+      free (ref);
+      return -1;
+    }
+  for (i = 0; i < seg->page_cnt; i++)
+    {
+      seg->pages[i] = palloc_get_page (PAL_USER | PAL_ZERO);
+      if (seg->pages[i] == NULL)
+        {
+          free_segment (seg);
+          free (ref);
+          return -1;
+        }
+    }
+  seg->ref_cnt = 1;
+
+  lock_acquire (&shm_lock);
+  seg->handle = next_handle++;
+  list_push_back (&segments, &seg->elem);
+  lock_release (&shm_lock);
+
+  ref->segment = seg;
+  ref->uaddr = NULL;
+  list_push_back (&thread_current ()->shm_refs, &ref->elem);
+  return seg->handle;
+}
+
+/* Maps segment HANDLE into the running process's address space
+   at page-aligned user virtual address UADDR.  Returns UADDR if
+   successful, or a null pointer if HANDLE is not a segment,
+   UADDR is null or misaligned, the segment would overlap pages
+   already in use, or memory is short. */
+void *
+shm_map (int handle, void *uaddr)
+{
+  struct thread *t = thread_current ();
+  struct shm_segment *seg;
+  struct shm_ref *ref;
+
+  if (uaddr == NULL || pg_ofs (uaddr) != 0)
+    return NULL;
+
+  ref = malloc (sizeof *ref);
+  if (ref == NULL)
+    return NULL;
+  seg = get_segment (handle);
+  if (seg == NULL)
+    {
+      free (ref);
+      return NULL;
+    }
+  if (!range_is_free (t->pagedir, uaddr, seg->page_cnt)
+      || !map_segment (t->pagedir, seg, uaddr))
+    {
+      put_segment (seg);
+      free (ref);
+      return NULL;
+    }
+
+  ref->segment = seg;
+  ref->uaddr = uaddr;
+  list_push_back (&t->shm_refs, &ref->elem);
+  return uaddr;
+}
+
+/* Unmaps the segment that the running process mapped at UADDR.
+   Returns true if successful, false if no segment is mapped
+   there. */
+bool
+shm_unmap (void *uaddr)
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  if (uaddr == NULL)
+    return false;
+
+  for (e = list_begin (&t->shm_refs); e != list_end (&t->shm_refs);
+       e = list_next (e))
+    {
+      struct shm_ref *ref = list_entry (e, struct shm_ref, elem);
+
+      if (ref->uaddr == uaddr)
+        {
+          pagedir_clear_range (t->pagedir, uaddr, ref->segment->page_cnt);
+          list_remove (&ref->elem);
+          put_segment (ref->segment);
+          free (ref);
+          return true;
+        }
+    }
+  return false;
+}
+
+/* Gives the running thread, which was just created by
+   process_fork() and has a copy of PARENT's address space, a
+   reference to each of PARENT's segments, and maps each mapped
+   segment at the same address as in PARENT.  Returns true if
+   successful, false if memory is short. */
+bool
+shm_copy (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&parent->shm_refs); e != list_end (&parent->shm_refs);
+       e = list_next (e))
+    {
+      struct shm_ref *pref = list_entry (e, struct shm_ref, elem);
+      struct shm_segment *seg = pref->segment;
+      struct shm_ref *ref = malloc (sizeof *ref);
+
+      if (ref == NULL)
+        return false;
+
+#ifndef VM
+      /* Drop the private copies that pagedir_copy() made. */
+      if (pref->uaddr != NULL)
+        {
+          size_t i;
+
+          for (i = 0; i < seg->page_cnt; i++)
+            {
+              void *upage = (uint8_t *) pref->uaddr + i * PGSIZE;
+              palloc_free_page (pagedir_get_page (t->pagedir, upage));
+            }
+          pagedir_clear_range (t->pagedir, pref->uaddr, seg->page_cnt);
+        }
+#endif
+
+      lock_acquire (&shm_lock);
+      seg->ref_cnt++;
+      lock_release (&shm_lock);
+      if (pref->uaddr != NULL && !map_segment (t->pagedir, seg, pref->uaddr))
+        {
+          put_segment (seg);
+          free (ref);
+          return false;
+        }
+
+      ref->segment = seg;
+      ref->uaddr = pref->uaddr;
+      list_push_back (&t->shm_refs, &ref->elem);
+    }
+  return true;
+}
+
+/* Unmaps all of the running process's segments and drops its
+   references to them.  Must be called before the process's page
+   directory is destroyed. */
+void
+shm_exit (void)
+{
+  struct thread *t = thread_current ();
+
+  while (!list_empty (&t->shm_refs))
+    {
+      struct shm_ref *ref = list_entry (list_pop_front (&t->shm_refs),
+                                        struct shm_ref, elem);
+
+      if (ref->uaddr != NULL && t->pagedir != NULL)
+        pagedir_clear_range (t->pagedir, ref->uaddr,
+                             ref->segment->page_cnt);
+      put_segment (ref->segment);
+      free (ref);
+    }
+}
+
+/* Returns segment HANDLE with a new reference to it, or a null
+   pointer if there is no such segment. */
+static struct shm_segment *
+get_segment (int handle)
+{
+  struct list_elem *e;
+
+  lock_acquire (&shm_lock);
+  for (e = list_begin (&segments); e != list_end (&segments);
+       e = list_next (e))
+    {
+      struct shm_segment *seg = list_entry (e, struct shm_segment, elem);
+
+      if (seg->handle == handle)
+        {
+          seg->ref_cnt++;
+          lock_release (&shm_lock);
+          return seg;
+        }
+    }
+  lock_release (&shm_lock);
+  return NULL;
+}
+
+/* Drops a reference to SEG, freeing it if it was the last
+   one. */
+static void
+put_segment (struct shm_segment *seg)
+{
+  bool last;
+
+  lock_acquire (&shm_lock);
+  ASSERT (seg->ref_cnt > 0);
+  last = --seg->ref_cnt == 0;
+  if (last)
+    list_remove (&seg->elem);
+  lock_release (&shm_lock);
+  if (last)
+    free_segment (seg);
+}
+
+/* Frees SEG and its pages. */
+static void
+free_segment (struct shm_segment *seg)
+{
+  size_t i;
+
+  for (i = 0; i < seg->page_cnt; i++)
+    palloc_free_page (seg->pages[i]);
+  free (seg->pages);
+  free (seg);
+}
+
+/* Returns true if the PAGE_CNT pages starting at UADDR all lie
+   in user virtual memory and none of them is in use in page
+   directory PD or, with virtual memory, in the running process's
+   supplemental page table. */
+static bool
+range_is_free (uint32_t *pd, void *uaddr, size_t page_cnt)
+{
+  uint8_t *base = uaddr;
+  size_t i;
+
+  if (page_cnt > ((uintptr_t) PHYS_BASE - (uintptr_t) base) / PGSIZE)
+    return false;
+
+  for (i = 0; i < page_cnt; i++)
+    {
+      void *upage = base + i * PGSIZE;
+
+      if (pagedir_get_phys (pd, upage) != 0)
+        return false;
+#ifdef VM
+      if (page_lookup (upage) != NULL)
+        return false;
+#endif
+    }
+  return true;
+}
+
+/* Maps SEG's pages into page directory PD at UADDR, writable.
+   Returns true if successful, false if memory is short, in which
+   case none of them are left mapped. */
+static bool
+map_segment (uint32_t *pd, struct shm_segment *seg, void *uaddr)
+{
+  size_t i;
+
+  for (i = 0; i < seg->page_cnt; i++)
+    if (!pagedir_set_page (pd, (uint8_t *) uaddr + i * PGSIZE,
+                           seg->pages[i], true))
+      {
+        pagedir_clear_range (pd, uaddr, i);
+        return false;
+      }
+  return true;
+}
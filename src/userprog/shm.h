@@ -0,0 +1,16 @@
+#ifndef USERPROG_SHM_H
+#define USERPROG_SHM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct thread;
+
+void shm_init (void);
+int shm_create (size_t size);
+void *shm_map (int handle, void *uaddr);
+bool shm_unmap (void *uaddr);
+bool shm_copy (struct thread *parent);
+void shm_exit (void);
+
+#endif /* userprog/shm.h */
@@ -1,20 +1,882 @@
 #include "userprog/syscall.h"
+#include <poll.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <syscall-nr.h>
+#include <uio.h>
+#include "devices/input.h"
+#include "devices/shutdown.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "filesys/inode.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
+#include "threads/loader.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/fd.h"
+#include "userprog/ipc.h"
+#include "userprog/pipe.h"
+#include "userprog/poll.h"
+#include "userprog/process.h"
+#include "userprog/ring.h"
+#include "userprog/shm.h"
+#include "userprog/tss.h"
+#include "userprog/uaccess.h"
+#ifdef VM
+#include "vm/mmap.h"
+#endif
 
-static void syscall_handler (struct intr_frame *);
+/* System calls.
+
+   A user process makes a system call by pushing its arguments
+   and then the system call number, from lib/syscall-nr.h, on its
+   stack and executing "int $0x30".  syscall_handler() copies in
+   the number and then the arguments, and calls the function for
+   that number in syscalls[], whose return value goes back to the
+   process in its eax register.  On CPUs that support it, the
+   process may execute SYSENTER instead of "int $0x30", with the
+   same stack layout; see userprog/sysenter.S.
+
+   User pointers are not checked before they are used.  The copy
+   functions in userprog/uaccess.c simply try, and a process that
+   passes a bad pointer is terminated with exit status -1.
+
+   File system calls must not touch user memory while holding
+   filesys_lock, because bringing in a user page may need the
+   lock.  Reads and writes pin the user's pages instead; see
+   transfer(). */
+
+/* Maximum number of arguments to a system call. */
+#define SYSCALL_ARGS_MAX 5
+
+/* Most bytes copied by copy_file_range() per acquisition of
+   filesys_lock. */
+#define COPY_CHUNK (64 * 1024)
+
+/* A system call implementation.  ARGS holds the call's
+   arguments, copied in from the user stack, and F is the
+   caller's interrupt frame.  Returns the value for the caller's
+   eax register. */
+typedef uint32_t syscall_func (const uint32_t args[], struct intr_frame *f);
+
+/* A system call table entry. */
+struct syscall
+  {
+    syscall_func *func;         /* Implementation. */
+    size_t arg_cnt;             /* Number of arguments. */
+  };
+
+static syscall_func sys_halt, sys_exit, sys_exec, sys_wait, sys_fork;
+static syscall_func sys_create, sys_remove, sys_open, sys_filesize;
+static syscall_func sys_read, sys_write, sys_seek, sys_tell, sys_close;
+static syscall_func sys_ring_setup, sys_ring_enter;
+static syscall_func sys_readv, sys_writev, sys_pread, sys_pwrite;
+static syscall_func sys_copy_file_range;
+static syscall_func sys_pipe, sys_dup, sys_dup2;
+static syscall_func sys_ipc_call, sys_ipc_reply_wait;
+static syscall_func sys_poll;
+static syscall_func sys_shm_create, sys_shm_map, sys_shm_unmap;
+#ifdef VM
+static syscall_func sys_mmap, sys_munmap, sys_msync, sys_memstat;
+#endif
+
+/* System calls, indexed by number.  Calls that this kernel does
+   not implement have null entries. */
+static const struct syscall syscalls[] =
+  {
+    [SYS_HALT] = {sys_halt, 0},
+    [SYS_EXIT] = {sys_exit, 1},
+    [SYS_EXEC] = {sys_exec, 1},
+    [SYS_WAIT] = {sys_wait, 1},
+    [SYS_CREATE] = {sys_create, 2},
+    [SYS_REMOVE] = {sys_remove, 1},
+    [SYS_OPEN] = {sys_open, 1},
+    [SYS_FILESIZE] = {sys_filesize, 1},
+    [SYS_READ] = {sys_read, 3},
+    [SYS_WRITE] = {sys_write, 3},
+    [SYS_SEEK] = {sys_seek, 2},
+    [SYS_TELL] = {sys_tell, 1},
+    [SYS_CLOSE] = {sys_close, 1},
+#ifdef VM
+    [SYS_MMAP] = {sys_mmap, 2},
+    [SYS_MUNMAP] = {sys_munmap, 1},
+    [SYS_MSYNC] = {sys_msync, 1},
+    [SYS_MEMSTAT] = {sys_memstat, 1},
+#endif
+    [SYS_FORK] = {sys_fork, 0},
+    [SYS_RING_SETUP] = {sys_ring_setup, 1},
+    [SYS_RING_ENTER] = {sys_ring_enter, 2},
+    [SYS_READV] = {sys_readv, 3},
+    [SYS_WRITEV] = {sys_writev, 3},
+    [SYS_PREAD] = {sys_pread, 4},
+    [SYS_PWRITE] = {sys_pwrite, 4},
+    [SYS_COPY_FILE_RANGE] = {sys_copy_file_range, 5},
+    [SYS_PIPE] = {sys_pipe, 1},
+    [SYS_DUP] = {sys_dup, 1},
+    [SYS_DUP2] = {sys_dup2, 2},
+    [SYS_IPC_CALL] = {sys_ipc_call, 1},
+    [SYS_IPC_REPLY_WAIT] = {sys_ipc_reply_wait, 1},
+    [SYS_POLL] = {sys_poll, 3},
+    [SYS_SHM_CREATE] = {sys_shm_create, 1},
+    [SYS_SHM_MAP] = {sys_shm_map, 2},
+    [SYS_SHM_UNMAP] = {sys_shm_unmap, 1},
+  };
+
+void syscall_handler (struct intr_frame *);
+void sysenter_entry (void);
+static void copy_in (void *dst, const void *usrc, size_t size);
+static char *copy_in_string (const char *ustr);
+
+static bool copy_in_iov (struct iovec *, const struct iovec *uiov,
+                         size_t iov_cnt);
+static int transfer (int fd, const struct iovec *, size_t iov_cnt,
+                     off_t ofs, bool write);
+static int transfer_pipe (struct pipe *, uint8_t *ubuf, size_t size,
+                          bool write, bool may_wait);
+static void read_console (uint8_t *ubuf, size_t size);
 
 void
-syscall_init (void) 
+syscall_init (void)
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
+  ring_init ();
+  shm_init ();
+
+  /* Also accept system calls through SYSENTER, if the CPU has
+     it.  SYSENTER loads %esp from its MSR directly, so we point
+     it at the TSS's esp0, which tss_update() keeps current, and
+     let sysenter_entry load the real stack pointer from there. */
+  if (cpu_has_features (CPUID_SEP))
+    {
+      write_msr (MSR_SYSENTER_CS, SEL_KCSEG);
+      write_msr (MSR_SYSENTER_ESP, (uintptr_t) tss_esp0 ());
+      write_msr (MSR_SYSENTER_EIP, (uintptr_t) sysenter_entry);
+    }
+}
+
+/* System call handler, for both "int $0x30" and SYSENTER
+   (through sysenter_entry in userprog/sysenter.S). */
+void
+syscall_handler (struct intr_frame *f)
+{
+  uint32_t *usp = f->esp;
+  uint32_t args[SYSCALL_ARGS_MAX];
+  const struct syscall *sc;
+  uint32_t nr;
+
+  /* Page faults on user memory in the kernel need this to
+     recognize stack accesses. */
+  thread_current ()->user_esp = f->esp;
+
+  copy_in (&nr, usp, sizeof nr);
+  if (nr >= sizeof syscalls / sizeof *syscalls
+      || syscalls[nr].func == NULL)
+    process_terminate (-1);
+  sc = &syscalls[nr];
+  copy_in (args, usp + 1, sc->arg_cnt * sizeof *args);
+  f->eax = sc->func (args, f);
+}
+
+/* Runs system call NR with arguments ARGS for the running
+   process, just as if the process had made the call itself, and
+   returns its result.  Used for calls submitted through a ring,
+   so NR must not be one that needs the caller's interrupt
+   frame. */
+uint32_t
+syscall_invoke (unsigned nr, const uint32_t args[])
+{
+  ASSERT (nr < sizeof syscalls / sizeof *syscalls);
+  ASSERT (syscalls[nr].func != NULL && nr != SYS_FORK
+          && nr != SYS_IPC_CALL && nr != SYS_IPC_REPLY_WAIT);
+  return syscalls[nr].func (args, NULL);
+}
+
+/* Copies SIZE bytes from user address USRC to kernel address
+   DST, terminating the process if USRC is a bad pointer. */
+static void
+copy_in (void *dst, const void *usrc, size_t size)
+{
+  if (!copy_from_user (dst, usrc, size))
+    process_terminate (-1);
+}
+
+/* Copies the null-terminated string at user address USTR into a
+   new page of kernel memory and returns it.  The caller must
+   free the page with palloc_free_page().  Returns a null pointer
+   if the string does not fit in a page or memory is short.
+   Terminates the process if USTR is a bad pointer. */
+static char *
+copy_in_string (const char *ustr)
+{
+  char *kstr = palloc_get_page (0);
+  int len;
+
+  if (kstr == NULL)
+    return NULL;
+  len = strncpy_from_user (kstr, ustr, PGSIZE);
+  if (len < 0)
+    {
+      palloc_free_page (kstr);
+      process_terminate (-1);
+    }
+  if (len == PGSIZE)
+    {
+      palloc_free_page (kstr);
+      return NULL;
+    }
+  return kstr;
+}
+
+/* Halt system call. */
+static uint32_t
+sys_halt (const uint32_t args[] UNUSED, struct intr_frame *f UNUSED)
+{
+  shutdown_power_off ();
+}
+
+/* Exit system call. */
+static uint32_t
+sys_exit (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  process_terminate ((int) args[0]);
+}
+
+/* Exec system call. */
+static uint32_t
+sys_exec (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  char *cmd_line = copy_in_string ((const char *) args[0]);
+  tid_t tid;
+
+  if (cmd_line == NULL)
+    return TID_ERROR;
+  tid = process_execute (cmd_line);
+  palloc_free_page (cmd_line);
+  return tid;
+}
+
+/* Wait system call. */
+static uint32_t
+sys_wait (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  return process_wait ((tid_t) args[0]);
+}
+
+/* Fork system call. */
+static uint32_t
+sys_fork (const uint32_t args[] UNUSED, struct intr_frame *f)
+{
+  return process_fork (f);
+}
+
+/* Create system call. */
+static uint32_t
+sys_create (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  char *name = copy_in_string ((const char *) args[0]);
+  bool success;
+
+  if (name == NULL)
+    return false;
+  success = false;
+  if ((off_t) args[1] >= 0)
+    {
+      lock_acquire (&filesys_lock);
+      success = filesys_create (name, args[1]);
+      lock_release (&filesys_lock);
+    }
+  palloc_free_page (name);
+  return success;
+}
+
+/* Remove system call. */
+static uint32_t
+sys_remove (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  char *name = copy_in_string ((const char *) args[0]);
+  bool success;
+
+  if (name == NULL)
+    return false;
+  lock_acquire (&filesys_lock);
+  success = filesys_remove (name);
+  lock_release (&filesys_lock);
+  palloc_free_page (name);
+  return success;
+}
+
+/* Open system call. */
+static uint32_t
+sys_open (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  char *name = copy_in_string ((const char *) args[0]);
+  struct file *file;
+  int fd = -1;
+
+  if (name == NULL)
+    return -1;
+  lock_acquire (&filesys_lock);
+  file = filesys_open (name);
+  lock_release (&filesys_lock);
+  palloc_free_page (name);
+
+  if (file != NULL)
+    {
+      fd = fd_install (file);
+      if (fd < 0)
+        {
+          lock_acquire (&filesys_lock);
+          file_close (file);
+          lock_release (&filesys_lock);
+        }
+    }
+  return fd;
+}
+
+/* Filesize system call. */
+static uint32_t
+sys_filesize (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct file *file = fd_lookup (args[0]);
+  off_t size;
+
+  if (file == NULL)
+    return -1;
+  lock_acquire (&filesys_lock);
+  size = file_length (file);
+  lock_release (&filesys_lock);
+  return size;
+}
+
+/* Read system call. */
+static uint32_t
+sys_read (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct iovec iov = {(void *) args[1], args[2]};
+
+  return transfer (args[0], &iov, 1, -1, false);
+}
+
+/* Write system call. */
+static uint32_t
+sys_write (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct iovec iov = {(void *) args[1], args[2]};
+
+  return transfer (args[0], &iov, 1, -1, true);
+}
+
+/* Readv system call. */
+static uint32_t
+sys_readv (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct iovec iov[IOV_MAX];
+
+  if (!copy_in_iov (iov, (const struct iovec *) args[1], args[2]))
+    return -1;
+  return transfer (args[0], iov, args[2], -1, false);
+}
+
+/* Writev system call. */
+static uint32_t
+sys_writev (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct iovec iov[IOV_MAX];
+
+  if (!copy_in_iov (iov, (const struct iovec *) args[1], args[2]))
+    return -1;
+  return transfer (args[0], iov, args[2], -1, true);
+}
+
+/* Pread system call. */
+static uint32_t
+sys_pread (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct iovec iov = {(void *) args[1], args[2]};
+
+  if ((off_t) args[3] < 0)
+    return -1;
+  return transfer (args[0], &iov, 1, args[3], false);
+}
+
+/* Pwrite system call. */
+static uint32_t
+sys_pwrite (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct iovec iov = {(void *) args[1], args[2]};
+
+  if ((off_t) args[3] < 0)
+    return -1;
+  return transfer (args[0], &iov, 1, args[3], true);
+}
+
+/* Copy_file_range system call.  Each offset may be -1 to use
+   and advance that file's current position instead. */
+static uint32_t
+sys_copy_file_range (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct file *in = fd_lookup (args[0]);
+  off_t in_ofs = args[1];
+  struct file *out = fd_lookup (args[2]);
+  off_t out_ofs = args[3];
+  size_t size = args[4];
+  size_t total = 0;
+  off_t length;
+
+  if (in == NULL || out == NULL || in_ofs < -1 || out_ofs < -1)
+    return -1;
+
+  lock_acquire (&filesys_lock);
+  if (in_ofs < 0)
+    in_ofs = file_tell (in);
+  if (out_ofs < 0)
+    out_ofs = file_tell (out);
+  length = file_length (in);
+  if (in_ofs >= length)
+    size = 0;
+  else if (size > (size_t) (length - in_ofs))
+    size = length - in_ofs;
+
+  /* The destination range must not run past the largest file
+     offset.  The source range can't, because SIZE now stops at
+     the end of the file.  Copying within a file between
+     overlapping ranges would overwrite data before it is
+     copied. */
+  if ((size_t) (INT32_MAX - out_ofs) < size
+      || (file_get_inode (in) == file_get_inode (out)
+          && in_ofs < out_ofs + (off_t) size
+          && out_ofs < in_ofs + (off_t) size))
+    {
+      lock_release (&filesys_lock);
+      return -1;
+    }
+  lock_release (&filesys_lock);
+
+  /* Copy a piece at a time, so as not to keep other processes
+     out of the file system for the whole copy. */
+  while (total < size)
+    {
+      off_t chunk = size - total < COPY_CHUNK ? size - total : COPY_CHUNK;
+      off_t copied;
+
+      lock_acquire (&filesys_lock);
+      copied = file_copy_at (out, out_ofs + total, in, in_ofs + total, chunk);
+      lock_release (&filesys_lock);
+      total += copied;
+      if (copied < chunk)
+        break;
+    }
+
+  lock_acquire (&filesys_lock);
+  if ((off_t) args[1] < 0)
+    file_seek (in, in_ofs + total);
+  if ((off_t) args[3] < 0)
+    file_seek (out, out_ofs + total);
+  lock_release (&filesys_lock);
+  return total;
+}
+
+/* Copies the IOV_CNT-element array of buffers at user address
+   UIOV into IOV, which must have room for IOV_MAX elements.
+   Returns false if IOV_CNT is out of range, terminates the
+   process if UIOV is a bad pointer. */
+static bool
+copy_in_iov (struct iovec *iov, const struct iovec *uiov, size_t iov_cnt)
+{
+  if (iov_cnt == 0 || iov_cnt > IOV_MAX)
+    return false;
+  copy_in (iov, uiov, iov_cnt * sizeof *iov);
+  return true;
+}
+
+/* Moves data between FD and the IOV_CNT user buffers in IOV,
+   from FD into the buffers if WRITE is false, the other way if
+   it is true.  If OFS is nonnegative, the transfer starts at
+   byte offset OFS and the file position is left alone;
+   otherwise, it starts at and advances the file position.
+   Returns the number of bytes moved, or -1 if FD is not open for
+   the transfer.  Terminates the process if a buffer is bad.
+   Pipes and the console have no position, so OFS must be
+   negative for them.
+
+   There is no intermediate copy.  Each page of the buffers is
+   pinned in turn and handed to the file system, which reads or
+   writes it in place through its kernel address.  Whole sectors
+   go straight between the disk and the page, whenever the file
+   offset and the buffer are sector-aligned with each other.
+   Pipes and the console keyboard may have to wait, which must
+   not happen with a page pinned, so they are handled apart.
+
+   Pinning every page of the buffers at once, to move them all
+   under a single acquisition of filesys_lock, could deadlock:
+   a pinned frame may be shared with another of the pages, or
+   with a page another process has pinned.  A file transfer
+   instead holds the inode's I/O lock throughout, so that it is
+   atomic with respect to every other transfer on the same
+   file. */
+static int
+transfer (int fd, const struct iovec *iov, size_t iov_cnt, off_t ofs,
+          bool write)
+{
+  struct open_file *of = fd_get (fd);
+  struct inode *inode = NULL;
+  size_t total = 0;
+  size_t i;
+
+  if (of == NULL)
+    return -1;
+  switch (of->type)
+    {
+    case FD_FILE:
+      break;
+
+    case FD_CONSOLE_IN:
+    case FD_PIPE_READ:
+      if (write || ofs >= 0)
+        return -1;
+      break;
+
+    case FD_CONSOLE_OUT:
+    case FD_PIPE_WRITE:
+      if (!write || ofs >= 0)
+        return -1;
+      break;
+    }
+
+  if (of->type == FD_FILE)
+    {
+      inode = file_get_inode (of->file);
+      inode_lock (inode);
+    }
+  for (i = 0; i < iov_cnt; i++)
+    {
+      uint8_t *ubuf = iov[i].iov_base;
+      size_t left = iov[i].iov_len;
+
+      if (of->type == FD_PIPE_READ || of->type == FD_PIPE_WRITE)
+        {
+          /* A pipe with no readers left takes no more data, and a
+             read returns whatever data there is without waiting
+             for more. */
+          int moved = transfer_pipe (of->pipe, ubuf, left, write,
+                                     write || total == 0);
+
+          if (moved < 0)
+            return total > 0 ? (int) total : -1;
+          total += moved;
+          if ((size_t) moved < left)
+            return total;
+          continue;
+        }
+      if (of->type == FD_CONSOLE_IN)
+        {
+          read_console (ubuf, left);
+          total += left;
+          continue;
+        }
+
+      while (left > 0)
+        {
+          size_t chunk = PGSIZE - pg_ofs (ubuf);
+          struct user_page up;
+          uint8_t *kbuf;
+          off_t moved;
+
+          if (chunk > left)
+            chunk = left;
+          if (!uaccess_pin (ubuf, !write, &up))
+            {
+              if (inode != NULL)
+                inode_unlock (inode);
+              process_terminate (-1);
+            }
+          kbuf = up.kaddr + pg_ofs (ubuf);
+
+          switch (of->type)
+            {
+            case FD_CONSOLE_OUT:
+              putbuf ((const char *) kbuf, chunk);
+              moved = chunk;
+              break;
+
+            case FD_FILE:
+            default:
+              lock_acquire (&filesys_lock);
+              if (ofs >= 0)
+                moved = (write
+                         ? file_write_at (of->file, kbuf, chunk, ofs + total)
+                         : file_read_at (of->file, kbuf, chunk, ofs + total));
+              else
+                moved = (write
+                         ? file_write (of->file, kbuf, chunk)
+                         : file_read (of->file, kbuf, chunk));
+              lock_release (&filesys_lock);
+              break;
+            }
+          uaccess_unpin (&up);
+
+          total += moved;
+          if ((size_t) moved < chunk)
+            goto done;
+          ubuf += chunk;
+          left -= chunk;
+        }
+    }
+
+ done:
+  if (inode != NULL)
+    inode_unlock (inode);
+  return total;
 }
 
+/* Moves up to SIZE bytes between pipe P and user buffer UBUF,
+   from P into UBUF if WRITE is false, the other way if it is
+   true.  A write waits for room until all SIZE bytes are
+   written.  A read returns as soon as it has read anything, and
+   waits for data only if MAY_WAIT is true.  Returns the number
+   of bytes moved, which is 0 for a read at end of file, or -1
+   for a write if every read end is closed before any byte could
+   be written.
+
+   Each page of UBUF is pinned only while bytes move without
+   blocking, and unpinned before waiting, because the process at
+   the other end may need the same frame to make progress. */
+static int
+transfer_pipe (struct pipe *p, uint8_t *ubuf, size_t size,
+               bool write, bool may_wait)
+{
+  size_t done = 0;
+
+  while (done < size)
+    {
+      uint8_t *uaddr = ubuf + done;
+      size_t chunk = PGSIZE - pg_ofs (uaddr);
+      struct user_page up;
+      int moved;
+
+      if (chunk > size - done)
+        chunk = size - done;
+      if (!uaccess_pin (uaddr, !write, &up))
+        process_terminate (-1);
+      moved = (write
+               ? pipe_write (p, up.kaddr + pg_ofs (uaddr), chunk)
+               : pipe_read (p, up.kaddr + pg_ofs (uaddr), chunk));
+      uaccess_unpin (&up);
+
+      if (moved < 0)
+        break;
+      done += moved;
+      if (!write && (done > 0 || !may_wait))
+        {
+          if ((size_t) moved < chunk)
+            break;
+        }
+      else if (moved == 0 && !pipe_wait (p, write))
+        break;
+    }
+  return write && done == 0 && size > 0 ? -1 : (int) done;
+}
+
+/* Reads SIZE keys from the console keyboard into user buffer
+   UBUF.  The keys go through a small kernel buffer, so that no
+   user page stays pinned while waiting for a key.  Terminates
+   the process if UBUF is bad. */
 static void
-syscall_handler (struct intr_frame *f UNUSED) 
+read_console (uint8_t *ubuf, size_t size)
+{
+  uint8_t keys[64];
+
+  while (size > 0)
+    {
+      size_t n = size < sizeof keys ? size : sizeof keys;
+      size_t i;
+
+      for (i = 0; i < n; i++)
+        keys[i] = input_getc ();
+      if (!copy_to_user (ubuf, keys, n))
+        process_terminate (-1);
+      ubuf += n;
+      size -= n;
+    }
+}
+
+/* Seek system call. */
+static uint32_t
+sys_seek (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct file *file = fd_lookup (args[0]);
+
+  if (file != NULL && (off_t) args[1] >= 0)
+    {
+      lock_acquire (&filesys_lock);
+      file_seek (file, args[1]);
+      lock_release (&filesys_lock);
+    }
+  return 0;
+}
+
+/* Tell system call. */
+static uint32_t
+sys_tell (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct file *file = fd_lookup (args[0]);
+  off_t position;
+
+  if (file == NULL)
+    return -1;
+  lock_acquire (&filesys_lock);
+  position = file_tell (file);
+  lock_release (&filesys_lock);
+  return position;
+}
+
+/* Close system call. */
+static uint32_t
+sys_close (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  /* A request in the process's ring might be using the file. */
+  ring_wait_idle ();
+  fd_close (args[0]);
+  return 0;
+}
+
+/* Pipe system call. */
+static uint32_t
+sys_pipe (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct pipe *p = pipe_create ();
+  int fds[2];
+
+  if (p == NULL || !fd_install_pipe (p, fds))
+    return false;
+  if (!copy_to_user ((void *) args[0], fds, sizeof fds))
+    process_terminate (-1);
+  return true;
+}
+
+/* Dup system call. */
+static uint32_t
+sys_dup (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  return fd_dup (args[0]);
+}
+
+/* Dup2 system call. */
+static uint32_t
+sys_dup2 (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  /* A request in the process's ring might be using the file that
+     the new descriptor refers to. */
+  ring_wait_idle ();
+  return fd_dup2 (args[0], args[1]);
+}
+
+#ifdef VM
+/* Mmap system call. */
+static uint32_t
+sys_mmap (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct file *file = fd_lookup (args[0]);
+
+  if (file == NULL)
+    return MAP_FAILED;
+  return mmap_map (file, (void *) args[1]);
+}
+
+/* Munmap system call. */
+static uint32_t
+sys_munmap (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  mmap_unmap (args[0]);
+  return 0;
+}
+
+/* Msync system call. */
+static uint32_t
+sys_msync (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  return mmap_sync (args[0]);
+}
+
+/* Memstat system call. */
+static uint32_t
+sys_memstat (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct thread *t = thread_current ();
+
+  if (!copy_to_user ((void *) args[0], &t->memstat, sizeof t->memstat))
+    process_terminate (-1);
+  return true;
+}
+#endif
+
+/* IPC call system call.  The message is in F's registers. */
+static uint32_t
+sys_ipc_call (const uint32_t args[], struct intr_frame *f)
+{
+  return ipc_call (args[0], f);
+}
+
+/* IPC reply-and-wait system call.  The message is in F's
+   registers. */
+static uint32_t
+sys_ipc_reply_wait (const uint32_t args[], struct intr_frame *f)
+{
+  return ipc_reply_wait (args[0], f);
+}
+
+/* Poll system call. */
+static uint32_t
+sys_poll (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct pollfd fds[POLL_MAX];
+  size_t nfds = args[1];
+  int ready;
+
+  if (nfds > POLL_MAX)
+    return -1;
+  copy_in (fds, (const void *) args[0], nfds * sizeof *fds);
+  ready = poll_wait (fds, nfds, args[2]);
+  if (ready >= 0
+      && !copy_to_user ((void *) args[0], fds, nfds * sizeof *fds))
+    process_terminate (-1);
+  return ready;
+}
+
+/* Ring setup system call. */
+static uint32_t
+sys_ring_setup (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  return ring_setup ((void *) args[0]);
+}
+
+/* Ring enter system call. */
+static uint32_t
+sys_ring_enter (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  return ring_enter (args[0], args[1]);
+}
+
+/* Shared memory create system call. */
+static uint32_t
+sys_shm_create (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  return shm_create (args[0]);
+}
+
+/* Shared memory map system call. */
+static uint32_t
+sys_shm_map (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  return (uint32_t) shm_map (args[0], (void *) args[1]);
+}
+
+/* Shared memory unmap system call. */
+static uint32_t
+sys_shm_unmap (const uint32_t args[], struct intr_frame *f UNUSED)
 {
-  printf ("system call!\n");
-  thread_exit ();
+  return shm_unmap ((void *) args[0]);
 }
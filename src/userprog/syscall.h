@@ -1,6 +1,9 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <stdint.h>
+
 void syscall_init (void);
+uint32_t syscall_invoke (unsigned nr, const uint32_t args[]);
 
 #endif /* userprog/syscall.h */
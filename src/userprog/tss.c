@@ -96,6 +96,17 @@ tss_get (void)
   return tss;
 }
 
+/* Returns the address of the ring 0 stack pointer in the kernel
+   TSS.  The TSS never moves and tss_update() keeps this pointing
+   to the top of the running thread's kernel stack, so the
+   SYSENTER entry path loads its stack pointer from here. */
+void **
+tss_esp0 (void)
+{
+  ASSERT (tss != NULL);
+  return &tss->esp0;
+}
+
 /* Sets the ring 0 stack pointer in the TSS to point to the end
    of the thread stack. */
 void
@@ -0,0 +1,155 @@
+#include "userprog/uaccess.h"
+#include <debug.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/page.h"
+#endif
+
+/* Access to user memory.
+
+   System calls get pointers from user processes, which may be
+   null, unmapped, or aimed at the kernel.  Rather than looking
+   up each page in the page directory before touching it, the
+   functions here only check that an address range lies below
+   PHYS_BASE, which is cheap, and then access it.  If a page
+   turns out to be missing, the page fault handler first tries to
+   bring it in as for any other fault.  Only if that fails is the
+   pointer bad, and then uaccess_fixup() makes the copy routine
+   return an error instead of the kernel panicking.  The copy
+   routines themselves, in usercopy.S, move a word at a time.
+
+   Bringing in a page may read a file or swap, so callers must
+   not hold filesys_lock or any other lock that the page fault
+   handler might need.  A caller that does need to hold such a
+   lock while accessing user memory, such as a read or write
+   system call that lets the file system move data in place,
+   pins the page first with uaccess_pin(). */
+
+/* In usercopy.S. */
+int usercopy (void *dst, const void *src, size_t size);
+int usercopy_str (char *dst, const char *src, size_t size);
+extern char uaccess_begin[], uaccess_end[], uaccess_fault[];
+
+/* Returns true if the SIZE bytes starting at UADDR all lie in
+   user virtual memory. */
+static bool
+is_user_range (const void *uaddr, size_t size)
+{
+  uintptr_t addr = (uintptr_t) uaddr;
+  uintptr_t end = (uintptr_t) PHYS_BASE;
+
+  return addr <= end && size <= end - addr;
+}
+
+/* Copies SIZE bytes from user address USRC to kernel address
+   DST.  Returns true if successful, false if USRC is not a valid
+   user buffer of SIZE bytes. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size)
+{
+  return is_user_range (usrc, size) && usercopy (dst, usrc, size) == 0;
+}
+
+/* Copies SIZE bytes from kernel address SRC to user address
+   UDST.  Returns true if successful, false if UDST is not a
+   valid, writable user buffer of SIZE bytes. */
+bool
+copy_to_user (void *udst, const void *src, size_t size)
+{
+  return is_user_range (udst, size) && usercopy (udst, src, size) == 0;
+}
+
+/* Copies the null-terminated string at user address USRC into
+   the SIZE bytes at DST.  Returns the length of the string, not
+   counting the null terminator, or SIZE if the string does not
+   fit, in which case DST is not null-terminated.  Returns -1 if
+   USRC is not a valid user string. */
+int
+strncpy_from_user (char *dst, const char *usrc, size_t size)
+{
+  uintptr_t addr = (uintptr_t) usrc;
+  size_t avail;
+  int len;
+
+  ASSERT (size <= INT32_MAX);
+
+  if (addr >= (uintptr_t) PHYS_BASE)
+    return -1;
+  avail = (uintptr_t) PHYS_BASE - addr;
+  len = usercopy_str (dst, usrc, size < avail ? size : avail);
+  if (len >= 0 && size > avail && (size_t) len == avail)
+    return -1;                  /* Runs into kernel memory. */
+  return len;
+}
+
+/* Brings in the page that contains user address UADDR and pins
+   it in memory, storing its kernel address into UP->kaddr, so
+   that it can be accessed while holding any lock.  If WRITE is
+   true, the page must be writable and the kernel may write to
+   it.  Returns true if successful, false if UADDR is a bad
+   pointer for the access.  The caller must release the page with
+   uaccess_unpin(), without holding locks that bringing in a page
+   might need. */
+bool
+uaccess_pin (const void *uaddr, bool write, struct user_page *up)
+{
+  uint32_t *pd = thread_current ()->pagedir;
+  const void *upage = pg_round_down (uaddr);
+
+  if (!is_user_vaddr (uaddr))
+    return false;
+
+#ifdef VM
+  /* Pages mapped outside the supplemental page table, such as
+     shared memory segments and rings, are never evicted, so they
+     are handled as without virtual memory. */
+  up->frame = NULL;
+  if (page_lookup (uaddr) != NULL || pagedir_get_page (pd, upage) == NULL)
+    {
+      up->frame = page_pin (uaddr, write);
+      if (up->frame == NULL)
+        return false;
+      up->kaddr = frame_kmap (up->frame);
+      return true;
+    }
+#endif
+
+  /* Without virtual memory, every page is always resident. */
+  up->kaddr = pagedir_get_page (pd, upage);
+  return up->kaddr != NULL && (!write || pagedir_is_writable (pd, upage));
+}
+
+/* Releases UP, pinned by uaccess_pin(). */
+void
+uaccess_unpin (struct user_page *up UNUSED)
+{
+#ifdef VM
+  if (up->frame != NULL)
+    {
+      frame_kunmap (up->frame, up->kaddr);
+      frame_unpin (up->frame);
+    }
+#endif
+}
+
+/* Called by the page fault handler for an unresolvable fault in
+   kernel mode, described by F.  If the fault happened in one of
+   the copy routines, makes it return an error and returns true.
+   Otherwise, returns false. */
+bool
+uaccess_fixup (struct intr_frame *f)
+{
+  char *eip = (char *) f->eip;
+
+  if (eip >= uaccess_begin && eip < uaccess_end)
+    {
+      f->eip = (void (*) (void)) uaccess_fault;
+      return true;
+    }
+  return false;
+}
@@ -0,0 +1,28 @@
+#ifndef USERPROG_UACCESS_H
+#define USERPROG_UACCESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct intr_frame;
+
+/* A user page pinned in memory, so that the kernel can access it
+   through KADDR even while holding locks that a page fault would
+   need. */
+struct user_page
+  {
+    uint8_t *kaddr;             /* Kernel address of the page. */
+#ifdef VM
+    struct frame *frame;        /* Pinned frame, or null. */
+#endif
+  };
+
+bool copy_from_user (void *dst, const void *usrc, size_t size);
+bool copy_to_user (void *udst, const void *src, size_t size);
+int strncpy_from_user (char *dst, const char *usrc, size_t size);
+bool uaccess_pin (const void *uaddr, bool write, struct user_page *);
+void uaccess_unpin (struct user_page *);
+bool uaccess_fixup (struct intr_frame *);
+
+#endif /* userprog/uaccess.h */
@@ -0,0 +1,1048 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "filesys/filesys.h"
+#include "filesys/inode.h"
+#include "threads/kmap.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+
+/* Frame table.
+
+   Every frame obtained from the user or high pool for a user
+   page is recorded here, along with the pages that occupy it: usually
+   just one, but after fork() parent and child share their
+   resident pages, read-only, until one of them writes to one
+   and gets its own copy from frame_unshare().  When
+   the user pool runs dry, frame_alloc() evicts resident pages
+   chosen by the clock algorithm: the frames form a circular
+   list, and a "hand" sweeps through it, clearing accessed bits
+   as it goes and stopping at each frame whose page has not been
+   accessed since the last sweep.  Victims that have to be
+   written to swap are evicted in clusters (see reclaim()), and
+   their frames return to the user pool once the swap writer
+   thread has written them.
+
+   Frames that hold read-only pages of files, such as program
+   text, are also entered in a cache keyed by where in the file
+   they come from, so that every process running the same
+   program shares one copy.  A frame leaves the cache when it
+   is freed, because its last page went away or because it was
+   evicted.  Frames read ahead of time (see vm/readahead.c) sit
+   in the cache with no pages at all until a process maps them;
+   those keep their inode open themselves.
+
+   Such a frame can outlive the processes that kept writes to
+   its file denied, so the file may be written behind its back.
+   Each cached frame therefore remembers the inode's version from
+   before it was read, and a lookup that finds the inode changed
+   since then takes the frame out of the cache.  A stale frame
+   with no pages is left for the clock to free.
+
+   A frame is "pinned" while its page is being read in or
+   written out, and while the kernel otherwise needs it to stay
+   put.  Pinned frames are never chosen for eviction, and
+   threads that need a page whose frame is pinned wait on
+   frame_cond until it is unpinned.
+
+   Frames come from the user pool first and then from the high
+   pool, whose pages the kernel can only get at through
+   frame_kmap().  Page tables map either kind by physical
+   address. */
+
+/* All frames that hold user pages, in clock order. */
+static struct list frames;
+
+/* Clock hand: next frame to consider for eviction. */
+static struct list_elem *clock_hand;
+
+/* Protects the frame list, the clock hand, the members of each
+   struct frame, and the `frame' member of each struct page. */
+static struct lock frame_lock;
+
+/* Signaled when a frame is unpinned or freed. */
+static struct condition frame_cond;
+
+/* Frames that hold read-only file data, keyed by inode, offset
+   and length.  Protected by frame_lock. */
+static struct hash file_frames;
+
+/* Page-out daemon.  Wakes up on pageout_cond when the number of
+   free frames in the user pool drops below low_water, and evicts
+   pages until free frames, counting those in clusters still
+   being written, reach high_water.  That way, most page faults
+   find a free frame immediately instead of having to evict one
+   themselves. */
+static size_t low_water, high_water;
+static bool pageout_running;
+static struct condition pageout_cond;
+
+/* Frames in clusters queued for writing.  They will return to
+   the user pool once written.  Protected by frame_lock. */
+static size_t pending_cnt;
+
+/* Frames being evicted together, whose pages are written to
+   consecutive swap slots by a single request. */
+struct cluster
+  {
+    struct frame *frames[SWAP_CLUSTER_PAGES]; /* Pinned victims. */
+    size_t frame_cnt;           /* Number of victims. */
+    struct swap_request req;    /* Request to write them. */
+    bool wait;                  /* Is the evicting thread waiting? */
+    struct semaphore done;      /* Upped when written, if WAIT. */
+  };
+
+static hash_hash_func file_frame_hash;
+static hash_less_func file_frame_less;
+static struct frame *find_file_frame (struct inode *, off_t ofs,
+                                      size_t bytes);
+static bool get_user_page (struct frame *, bool may_evict);
+static void put_user_page (struct frame *);
+static struct frame *alloc_frame (struct page *, bool may_evict);
+static void add_page (struct frame *, struct page *);
+static bool reclaim (bool wait);
+static struct frame *choose_victim (size_t *budget);
+static bool unmap (struct frame *);
+static struct page *write_back_page (struct frame *);
+static void restore (struct frame *);
+static void release (struct frame *);
+static void free_frame (struct frame *);
+static bool write_cluster (struct cluster *, bool wait);
+static void cluster_written (struct swap_request *);
+static void wake_pageout (void);
+static thread_func pageout_daemon NO_RETURN;
+
+/* Initializes the frame table. */
+void
+frame_init (void)
+{
+  list_init (&frames);
+  clock_hand = NULL;
+  lock_init (&frame_lock);
+  cond_init (&frame_cond);
+  cond_init (&pageout_cond);
+  if (!hash_init (&file_frames, file_frame_hash, file_frame_less, NULL))
+    PANIC ("frame: file frame cache creation failed");
+}
+
+/* Starts the page-out daemon, which tries to keep between
+   LOW_PAGES and HIGH_PAGES frames free in the user pool.  If
+   either is 0, a default based on the size of the user pool is
+   used instead. */
+void
+frame_start_pageout (size_t low_pages, size_t high_pages)
+{
+  size_t user_pages = palloc_capacity (PAL_USER);
+
+  low_water = low_pages;
+  if (low_water == 0)
+    {
+      low_water = user_pages / 32;
+      if (low_water < SWAP_CLUSTER_PAGES)
+        low_water = SWAP_CLUSTER_PAGES;
+    }
+  high_water = high_pages;
+  if (high_water == 0)
+    high_water = 2 * low_water;
+  if (high_water < low_water)
+    high_water = low_water;
+
+  /* Leave most of a tiny pool to the processes using it. */
+  if (high_water > user_pages / 2)
+    {
+      high_water = user_pages / 2;
+      if (low_water > high_water)
+        low_water = high_water;
+    }
+  if (low_water == 0)
+    return;
+
+  printf ("pageout: keeping %zu to %zu frames free\n",
+          low_water, high_water);
+  pageout_running = true;
+  thread_create ("pageoutd", PRI_DEFAULT, pageout_daemon, NULL);
+}
+
+/* Obtains a frame for page P, evicting other pages if the user
+   pool is exhausted.  The new frame is pinned and becomes P's
+   only frame; the caller must fill it in and then call
+   frame_unpin() or, on failure, frame_release().  Returns a
+   null pointer if no frame can be obtained. */
+struct frame *
+frame_alloc (struct page *p)
+{
+  return alloc_frame (p, true);
+}
+
+/* Obtains a frame for page P, which is read-only and consists of
+   BYTES bytes of INODE starting at offset OFS, followed by
+   zeros.  If another process already has those contents in a
+   frame, shares that frame with P and sets *LOADED to true.
+   Otherwise, allocates a frame like frame_alloc(), enters it in
+   the cache so that others can share it once it is filled in,
+   and sets *LOADED to false.  Either way, the frame is returned
+   pinned.  Returns a null pointer if no frame can be
+   obtained. */
+struct frame *
+frame_alloc_file (struct page *p, struct inode *inode, off_t ofs,
+                  size_t bytes, bool *loaded)
+{
+  struct frame *f;
+
+  ASSERT (!p->writable);
+  ASSERT (p->frame == NULL);
+
+  lock_acquire (&frame_lock);
+  for (;;)
+    {
+      f = find_file_frame (inode, ofs, bytes);
+      if (f == NULL)
+        break;
+      if (!f->pinned)
+        {
+          /* Someone else has already read the page. */
+          f->pinned = true;
+          add_page (f, p);
+          lock_release (&frame_lock);
+          *loaded = true;
+          return f;
+        }
+
+      /* Being read in or evicted.  Check again when that is
+         over. */
+      cond_wait (&frame_cond, &frame_lock);
+    }
+  lock_release (&frame_lock);
+
+  f = alloc_frame (p, true);
+  if (f == NULL)
+    return NULL;
+
+  /* If someone else got here while we were allocating, just keep
+     our frame to ourselves. */
+  lock_acquire (&frame_lock);
+  if (find_file_frame (inode, ofs, bytes) == NULL)
+    {
+      f->inode = inode;
+      f->file_ofs = ofs;
+      f->file_bytes = bytes;
+      f->inode_version = inode_version (inode);
+      f->cached = true;
+      hash_insert (&file_frames, &f->hash_elem);
+    }
+  lock_release (&frame_lock);
+
+  *loaded = false;
+  return f;
+}
+
+/* Makes page P, which is read-only and consists of BYTES bytes
+   of INODE starting at offset OFS, followed by zeros, share the
+   frame in the file frame cache that already holds those
+   contents, if there is one that is not busy.  Unlike
+   frame_alloc_file(), never waits, reads or evicts anything, so
+   it is suitable for mapping pages speculatively.  Returns the
+   frame, pinned, or a null pointer. */
+struct frame *
+frame_lookup_file (struct page *p, struct inode *inode, off_t ofs,
+                   size_t bytes)
+{
+  struct frame *f;
+
+  ASSERT (!p->writable);
+
+  lock_acquire (&frame_lock);
+  f = find_file_frame (inode, ofs, bytes);
+  if (f != NULL && !f->pinned && p->frame == NULL)
+    {
+      f->pinned = true;
+      add_page (f, p);
+    }
+  else
+    f = NULL;
+  lock_release (&frame_lock);
+
+  return f;
+}
+
+/* Obtains a frame for BYTES bytes of INODE starting at offset
+   OFS, followed by zeros, that no page occupies yet, and enters
+   it in the file frame cache, so that pages can share it once
+   the caller has filled it in and called frame_unpin().  Used
+   for reading ahead, so it never evicts anything, and fails if
+   the page-out daemon would have to run to make up for it.
+
+   On success, the frame takes over the caller's reference to
+   INODE, closing it when the frame is freed.  Returns a null
+   pointer on failure, setting *CACHED to true if that is because
+   the cache already holds the data. */
+struct frame *
+frame_alloc_cached (struct inode *inode, off_t ofs, size_t bytes,
+                    bool *cached)
+{
+  struct frame *f;
+
+  lock_acquire (&frame_lock);
+  *cached = find_file_frame (inode, ofs, bytes) != NULL;
+  lock_release (&frame_lock);
+  if (*cached || palloc_available (PAL_USER) <= low_water)
+    return NULL;
+
+  f = malloc (sizeof *f);
+  if (f == NULL)
+    return NULL;
+  if (!get_user_page (f, false))
+    {
+      free (f);
+      return NULL;
+    }
+
+  lock_acquire (&frame_lock);
+  *cached = find_file_frame (inode, ofs, bytes) != NULL;
+  if (!*cached)
+    {
+      list_init (&f->pages);
+      f->ref_cnt = 0;
+      f->pinned = true;
+      f->inode = inode;
+      f->file_ofs = ofs;
+      f->file_bytes = bytes;
+      f->inode_version = inode_version (inode);
+      f->cached = true;
+      f->inode_ref = true;
+      hash_insert (&file_frames, &f->hash_elem);
+      list_push_back (&frames, &f->elem);
+    }
+  lock_release (&frame_lock);
+
+  if (*cached)
+    {
+      put_user_page (f);
+      free (f);
+      return NULL;
+    }
+  return f;
+}
+
+/* Like frame_alloc(), but fails instead of evicting anything if
+   the user pool is exhausted.  Also fails if P already has a
+   frame.  Suitable for speculative reads. */
+struct frame *
+frame_try_alloc (struct page *p)
+{
+  return alloc_frame (p, false);
+}
+
+/* Detaches page P from frame F, which the caller must have
+   pinned.  If no other page shares F, frees it; otherwise,
+   unpins it. */
+void
+frame_release (struct frame *f, struct page *p)
+{
+  bool last;
+
+  lock_acquire (&frame_lock);
+  ASSERT (f->pinned);
+  ASSERT (p->frame == f);
+  last = f->ref_cnt == 1;
+  if (last)
+    release (f);
+  else
+    {
+      list_remove (&p->frame_elem);
+      f->ref_cnt--;
+      p->frame = NULL;
+      MEMSTAT_ADD (p->thread, resident, -1);
+      f->pinned = false;
+    }
+  cond_broadcast (&frame_cond, &frame_lock);
+  lock_release (&frame_lock);
+
+  if (last)
+    free_frame (f);
+}
+
+/* Makes page P, which must not be resident, share frame F with
+   the pages already in it.  F must be pinned by the caller. */
+void
+frame_share (struct frame *f, struct page *p)
+{
+  lock_acquire (&frame_lock);
+  ASSERT (f->pinned);
+  ASSERT (p->frame == NULL);
+  add_page (f, p);
+  lock_release (&frame_lock);
+}
+
+/* Gives page P a frame of its own, in preparation for writing to
+   it.  F must be P's frame, pinned by the caller.  If P is the
+   only page in F, just returns F.  Otherwise, copies F into a
+   newly allocated frame, which replaces F as P's frame and is
+   returned pinned, and unpins F.  Returns a null pointer, with F
+   still pinned, if no frame can be obtained. */
+struct frame *
+frame_unshare (struct frame *f, struct page *p)
+{
+  struct frame *copy;
+  void *dst, *src;
+
+  ASSERT (f->pinned);
+  ASSERT (p->frame == f);
+
+  /* Other pages can't leave F while we have it pinned, so if it
+     is shared now, it will still be when we are done. */
+  if (f->ref_cnt == 1)
+    return f;
+
+  copy = malloc (sizeof *copy);
+  if (copy == NULL)
+    return NULL;
+  if (!get_user_page (copy, true))
+    {
+      free (copy);
+      return NULL;
+    }
+  dst = frame_kmap (copy);
+  src = frame_kmap (f);
+  memcpy (dst, src, PGSIZE);
+  frame_kunmap (f, src);
+  frame_kunmap (copy, dst);
+
+  lock_acquire (&frame_lock);
+  list_remove (&p->frame_elem);
+  f->ref_cnt--;
+  f->pinned = false;
+  p->frame = NULL;
+  MEMSTAT_ADD (p->thread, resident, -1);
+  list_init (&copy->pages);
+  copy->ref_cnt = 0;
+  copy->pinned = true;
+  copy->inode = NULL;
+  copy->cached = false;
+  copy->inode_ref = false;
+  add_page (copy, p);
+  list_push_back (&frames, &copy->elem);
+  cond_broadcast (&frame_cond, &frame_lock);
+  lock_release (&frame_lock);
+
+  return copy;
+}
+
+/* If page P is resident, waits until its frame is not pinned,
+   then pins it and returns it.  Returns a null pointer if P is
+   not resident, including when it was evicted while we
+   waited. */
+struct frame *
+frame_pin (struct page *p)
+{
+  struct frame *f;
+
+  lock_acquire (&frame_lock);
+  while (p->frame != NULL && p->frame->pinned)
+    cond_wait (&frame_cond, &frame_lock);
+  f = p->frame;
+  if (f != NULL)
+    f->pinned = true;
+  lock_release (&frame_lock);
+
+  return f;
+}
+
+/* Unpins frame F, making it eligible for eviction again. */
+void
+frame_unpin (struct frame *f)
+{
+  lock_acquire (&frame_lock);
+  ASSERT (f->pinned);
+  f->pinned = false;
+  cond_broadcast (&frame_cond, &frame_lock);
+  lock_release (&frame_lock);
+}
+
+/* Returns a kernel virtual address at which the contents of
+   frame F, which the caller must have pinned, can be accessed.
+   For a frame in high memory, this maps F temporarily, possibly
+   waiting for a free kmap slot, so the caller should not hold
+   any locks.  Must be undone with frame_kunmap(). */
+void *
+frame_kmap (struct frame *f)
+{
+  return f->kpage != NULL ? f->kpage : kmap (f->paddr);
+}
+
+/* Undoes frame_kmap(), which returned KADDR for frame F. */
+void
+frame_kunmap (struct frame *f, const void *kaddr)
+{
+  if (f->kpage == NULL)
+    kunmap (kaddr);
+}
+
+/* Returns a hash value for the file frame that E refers to. */
+static unsigned
+file_frame_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct frame *f = hash_entry (e, struct frame, hash_elem);
+  return hash_bytes (&f->inode, sizeof f->inode) ^ hash_int (f->file_ofs);
+}
+
+/* Returns true if file frame A precedes file frame B. */
+static bool
+file_frame_less (const struct hash_elem *a_, const struct hash_elem *b_,
+                 void *aux UNUSED)
+{
+  const struct frame *a = hash_entry (a_, struct frame, hash_elem);
+  const struct frame *b = hash_entry (b_, struct frame, hash_elem);
+
+  if (a->inode != b->inode)
+    return a->inode < b->inode;
+  else if (a->file_ofs != b->file_ofs)
+    return a->file_ofs < b->file_ofs;
+  else
+    return a->file_bytes < b->file_bytes;
+}
+
+/* Returns the cached frame that holds BYTES bytes of INODE
+   starting at offset OFS, or a null pointer if there is none.
+   A frame that INODE has been written since is dropped from the
+   cache and not returned.
+   Must be called with frame_lock held. */
+static struct frame *
+find_file_frame (struct inode *inode, off_t ofs, size_t bytes)
+{
+  struct frame key;
+  struct hash_elem *e;
+  struct frame *f;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  key.inode = inode;
+  key.file_ofs = ofs;
+  key.file_bytes = bytes;
+  e = hash_find (&file_frames, &key.hash_elem);
+  if (e == NULL)
+    return NULL;
+  f = hash_entry (e, struct frame, hash_elem);
+  if (f->inode_version != inode_version (inode))
+    {
+      hash_delete (&file_frames, &f->hash_elem);
+      f->cached = false;
+      return NULL;
+    }
+  return f;
+}
+
+/* Obtains a page for frame F from the user pool or, failing
+   that, the high pool, and sets F's kpage and paddr members.  If
+   both pools are exhausted and MAY_EVICT is true, evicts other
+   pages to make room.  Returns true if successful, false if no
+   page can be obtained. */
+static bool
+get_user_page (struct frame *f, bool may_evict)
+{
+  /* Each successful reclaim() returns at least one frame to the
+     user pool, but another thread may get to it first. */
+  for (;;)
+    {
+      f->kpage = palloc_get_page (PAL_USER);
+      if (f->kpage != NULL)
+        {
+          f->paddr = vtop (f->kpage);
+          break;
+        }
+      f->paddr = palloc_get_high_page ();
+      if (f->paddr != 0)
+        break;
+
+      wake_pageout ();
+      if (!may_evict || !reclaim (true))
+        return false;
+    }
+  wake_pageout ();
+  return true;
+}
+
+/* Returns frame F's page to the pool it came from. */
+static void
+put_user_page (struct frame *f)
+{
+  if (f->kpage != NULL)
+    palloc_free_page (f->kpage);
+  else
+    palloc_free_high_page (f->paddr);
+}
+
+/* Obtains a pinned frame for page P, as described for
+   frame_alloc() if MAY_EVICT is true and for frame_try_alloc()
+   otherwise. */
+static struct frame *
+alloc_frame (struct page *p, bool may_evict)
+{
+  struct frame *f;
+
+  ASSERT (!may_evict || p->frame == NULL);
+
+  f = malloc (sizeof *f);
+  if (f == NULL)
+    return NULL;
+  if (!get_user_page (f, may_evict))
+    {
+      free (f);
+      return NULL;
+    }
+
+  lock_acquire (&frame_lock);
+  if (p->frame != NULL)
+    {
+      lock_release (&frame_lock);
+      put_user_page (f);
+      free (f);
+      return NULL;
+    }
+  list_init (&f->pages);
+  f->ref_cnt = 0;
+  f->pinned = true;
+  f->inode = NULL;
+  f->cached = false;
+  f->inode_ref = false;
+  add_page (f, p);
+  list_push_back (&frames, &f->elem);
+  lock_release (&frame_lock);
+
+  return f;
+}
+
+/* Adds page P to the pages in frame F.
+   Must be called with frame_lock held. */
+static void
+add_page (struct frame *f, struct page *p)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  list_push_back (&f->pages, &p->frame_elem);
+  f->ref_cnt++;
+  p->frame = f;
+  MEMSTAT_ADD (p->thread, resident, 1);
+}
+
+/* Evicts pages to return at least one frame to the user pool.
+
+   Victims come from the clock algorithm.  A victim whose pages
+   can simply be dropped, or written back to a memory-mapped
+   file, ends the scan at once.  Victims whose
+   pages must go to swap are gathered into a cluster instead,
+   until SWAP_CLUSTER_PAGES of them have been found, and the
+   cluster is then written by the swap writer thread.  If WAIT is
+   true, waits for the write to complete.
+
+   Returns true if at least one frame has been freed, or if WAIT
+   is false, will be freed once the cluster is written.  Returns
+   false if no victim could be found or swap space is full. */
+static bool
+reclaim (bool wait)
+{
+  struct cluster *c;
+  struct frame *victim = NULL;
+  struct frame *f;
+  size_t budget;
+  bool success = false;
+
+  c = malloc (sizeof *c);
+  if (c != NULL)
+    c->frame_cnt = 0;
+
+  lock_acquire (&frame_lock);
+  budget = 2 * list_size (&frames);
+  while (victim == NULL
+         && (c == NULL || c->frame_cnt < SWAP_CLUSTER_PAGES)
+         && (f = choose_victim (&budget)) != NULL)
+    {
+      struct page *p;
+
+      if (unmap (f))
+        {
+          if (c != NULL)
+            c->frames[c->frame_cnt++] = f;
+          else
+            restore (f);
+        }
+      else if ((p = write_back_page (f)) != NULL)
+        {
+          void *kaddr;
+          bool written;
+
+          lock_release (&frame_lock);
+          kaddr = frame_kmap (f);
+          written = page_write_back (p, kaddr);
+          frame_kunmap (f, kaddr);
+          lock_acquire (&frame_lock);
+          if (written)
+            {
+              release (f);
+              victim = f;
+            }
+          else
+            restore (f);
+        }
+      else
+        {
+          release (f);
+          victim = f;
+        }
+    }
+  cond_broadcast (&frame_cond, &frame_lock);
+  lock_release (&frame_lock);
+
+  if (victim != NULL)
+    {
+      free_frame (victim);
+      success = true;
+    }
+  if (c != NULL && c->frame_cnt > 0)
+    success = write_cluster (c, wait && victim == NULL) || success;
+  else
+    free (c);
+  return success;
+}
+
+/* Advances the clock hand to a frame whose page has not been
+   accessed recently, pins it, and returns it.  Gives up and
+   returns a null pointer once *BUDGET frames have been looked
+   at, decrementing *BUDGET for each one.
+   Must be called with frame_lock held. */
+static struct frame *
+choose_victim (size_t *budget)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  /* A budget of two sweeps is enough: the first clears every
+     accessed bit it passes, so the second must find a victim
+     unless all the frames are pinned. */
+  while (*budget > 0)
+    {
+      struct frame *f;
+      struct list_elem *e;
+      bool accessed = false;
+
+      --*budget;
+      if (clock_hand == NULL || clock_hand == list_end (&frames))
+        clock_hand = list_begin (&frames);
+      if (clock_hand == list_end (&frames))
+        break;
+      f = list_entry (clock_hand, struct frame, elem);
+      clock_hand = list_next (clock_hand);
+
+      if (f->pinned)
+        continue;
+
+      for (e = list_begin (&f->pages); e != list_end (&f->pages);
+           e = list_next (e))
+        {
+          struct page *p = list_entry (e, struct page, frame_elem);
+          uint32_t *pd = p->thread->pagedir;
+
+          if (pagedir_is_accessed (pd, p->addr))
+            {
+              pagedir_set_accessed (pd, p->addr, false);
+              accessed = true;
+            }
+        }
+      if (!accessed)
+        {
+          f->pinned = true;
+          return f;
+        }
+    }
+  return NULL;
+}
+
+/* Unmaps every page in pinned frame F, so that the owners can't
+   modify it behind our back while it is evicted.  If one of them
+   touches its page again, it will fault and wait for us to
+   finish in frame_pin().  Returns true if F's contents have to
+   be written to swap, false if they can be dropped.
+   Must be called with frame_lock held. */
+static bool
+unmap (struct frame *f)
+{
+  struct list_elem *e;
+  bool needs_swap = false;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (f->pinned);
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      uint32_t *pd = p->thread->pagedir;
+
+      pagedir_clear_page (pd, p->addr);
+      if (pagedir_is_dirty (pd, p->addr))
+        page_mark_dirty (p);
+      if (page_needs_swap (p))
+        needs_swap = true;
+    }
+  return needs_swap;
+}
+
+/* Returns the page in frame F, which has been unmapped for
+   eviction, if it is a page of a memory-mapped file that has to
+   be written back to its file first, or a null pointer
+   otherwise.
+   Must be called with frame_lock held. */
+static struct page *
+write_back_page (struct frame *f)
+{
+  struct page *p;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  if (f->ref_cnt != 1)
+    return NULL;
+  p = list_entry (list_front (&f->pages), struct page, frame_elem);
+  return page_needs_write_back (p) ? p : NULL;
+}
+
+/* Maps the pages in pinned frame F, which were unmapped for
+   eviction, back in place, and unpins F.  The caller must
+   broadcast frame_cond.
+   Must be called with frame_lock held. */
+static void
+restore (struct frame *f)
+{
+  struct list_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (f->pinned);
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+
+      if (!pagedir_set_phys (p->thread->pagedir, p->addr, f->paddr,
+                             p->writable && f->ref_cnt == 1))
+        NOT_REACHED ();
+    }
+  f->pinned = false;
+}
+
+/* Removes frame F from the frame table and detaches it from its
+   pages.  The caller must then call free_frame(), without
+   frame_lock held.
+   Must be called with frame_lock held. */
+static void
+release (struct frame *f)
+{
+  struct list_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  if (clock_hand == &f->elem)
+    clock_hand = list_next (clock_hand);
+  list_remove (&f->elem);
+  if (f->cached)
+    hash_delete (&file_frames, &f->hash_elem);
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      p->frame = NULL;
+      MEMSTAT_ADD (p->thread, resident, -1);
+    }
+}
+
+/* Frees frame F, which has been released, along with its page,
+   and closes its inode if it holds a reference to it.
+   Must not be called with frame_lock held, which is ordered
+   after filesys_lock. */
+static void
+free_frame (struct frame *f)
+{
+  ASSERT (!lock_held_by_current_thread (&frame_lock));
+
+  if (f->inode_ref)
+    {
+      lock_acquire (&filesys_lock);
+      inode_close (f->inode);
+      lock_release (&filesys_lock);
+    }
+  put_user_page (f);
+  free (f);
+}
+
+/* Returns true if frame A should be written to swap before frame
+   B, ordering clusters by owner and then by address so that
+   pages likely to be read back together end up in consecutive
+   slots.  Shared frames are ordered by their first page. */
+static bool
+cluster_less (const struct frame *a, const struct frame *b)
+{
+  const struct page *pa = list_entry (list_front ((struct list *) &a->pages),
+                                      struct page, frame_elem);
+  const struct page *pb = list_entry (list_front ((struct list *) &b->pages),
+                                      struct page, frame_elem);
+
+  if (pa->thread != pb->thread)
+    return pa->thread < pb->thread;
+  return pa->addr < pb->addr;
+}
+
+/* Allocates consecutive swap slots for the pages in cluster C
+   and queues them for writing, putting back any victims for
+   which no slot is available.  Takes ownership of C.  If WAIT is
+   true, returns only after the cluster has been written and its
+   frames freed.  Returns true if any page is being written,
+   false if swap space is full. */
+static bool
+write_cluster (struct cluster *c, bool wait)
+{
+  size_t cnt = c->frame_cnt;
+  size_t slot;
+  size_t i, j;
+
+  /* Insertion sort: clusters are small. */
+  for (i = 1; i < c->frame_cnt; i++)
+    {
+      struct frame *f = c->frames[i];
+      for (j = i; j > 0 && cluster_less (f, c->frames[j - 1]); j--)
+        c->frames[j] = c->frames[j - 1];
+      c->frames[j] = f;
+    }
+
+  slot = swap_alloc (&cnt);
+  if (slot == SWAP_ERROR)
+    cnt = 0;
+  if (cnt < c->frame_cnt)
+    {
+      lock_acquire (&frame_lock);
+      for (i = cnt; i < c->frame_cnt; i++)
+        restore (c->frames[i]);
+      cond_broadcast (&frame_cond, &frame_lock);
+      lock_release (&frame_lock);
+      c->frame_cnt = cnt;
+    }
+  if (cnt == 0)
+    {
+      free (c);
+      return false;
+    }
+
+  lock_acquire (&frame_lock);
+  pending_cnt += cnt;
+  lock_release (&frame_lock);
+
+  c->req.slot = slot;
+  c->req.page_cnt = cnt;
+  for (i = 0; i < cnt; i++)
+    c->req.kpages[i] = frame_kmap (c->frames[i]);
+  c->req.done = cluster_written;
+  c->req.aux = c;
+  c->wait = wait;
+  sema_init (&c->done, 0);
+
+  swap_write (&c->req);
+  if (wait)
+    {
+      sema_down (&c->done);
+      free (c);
+    }
+  return true;
+}
+
+/* Called by the swap writer thread when the cluster that R
+   belongs to has been written.  Detaches each page from its
+   frame, recording the page's new swap slot, and frees the
+   frames.  Pages that shared a frame share its swap slot. */
+static void
+cluster_written (struct swap_request *r)
+{
+  struct cluster *c = r->aux;
+  bool wait = c->wait;
+  size_t i;
+
+  lock_acquire (&frame_lock);
+  for (i = 0; i < c->frame_cnt; i++)
+    {
+      struct frame *f = c->frames[i];
+      struct list_elem *e;
+
+      for (e = list_begin (&f->pages); e != list_end (&f->pages);
+           e = list_next (e))
+        {
+          if (e != list_begin (&f->pages))
+            swap_dup (r->slot + i);
+          page_swapped_out (list_entry (e, struct page, frame_elem),
+                            r->slot + i);
+        }
+      release (f);
+    }
+  pending_cnt -= c->frame_cnt;
+  cond_broadcast (&frame_cond, &frame_lock);
+  lock_release (&frame_lock);
+
+  for (i = 0; i < c->frame_cnt; i++)
+    {
+      frame_kunmap (c->frames[i], r->kpages[i]);
+      put_user_page (c->frames[i]);
+      free (c->frames[i]);
+    }
+
+  if (wait)
+    sema_up (&c->done);
+  else
+    free (c);
+}
+
+/* Wakes up the page-out daemon if free frames are running
+   low. */
+static void
+wake_pageout (void)
+{
+  if (pageout_running && palloc_available (PAL_USER) < low_water)
+    {
+      lock_acquire (&frame_lock);
+      cond_signal (&pageout_cond, &frame_lock);
+      lock_release (&frame_lock);
+    }
+}
+
+/* Page-out daemon thread.  Sleeps until free frames drop below
+   low_water, then reclaims frames, without waiting for clusters
+   to be written, until free and pending frames reach
+   high_water or nothing more can be evicted. */
+static void
+pageout_daemon (void *aux UNUSED)
+{
+  for (;;)
+    {
+      bool progress = true;
+
+      lock_acquire (&frame_lock);
+      while (palloc_available (PAL_USER) >= low_water)
+        cond_wait (&pageout_cond, &frame_lock);
+
+      while (progress
+             && palloc_available (PAL_USER) + pending_cnt < high_water)
+        {
+          lock_release (&frame_lock);
+          progress = reclaim (false);
+          lock_acquire (&frame_lock);
+        }
+      lock_release (&frame_lock);
+
+      /* If nothing could be evicted, wait for things to change
+         instead of scanning again right away. */
+      if (!progress)
+        timer_msleep (10);
+    }
+}
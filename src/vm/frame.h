@@ -0,0 +1,56 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+struct inode;
+struct page;
+
+/* A physical frame of memory from the user or high pool that
+   holds a user page, possibly shared copy-on-write by several
+   processes.  Frames in high memory have no kernel virtual
+   address; see frame_kmap(). */
+struct frame
+  {
+    void *kpage;                /* Kernel virtual address, or null. */
+    uintptr_t paddr;            /* Physical address. */
+    struct list pages;          /* Pages in this frame. */
+    size_t ref_cnt;             /* Number of pages in PAGES. */
+    bool pinned;                /* Exempt from eviction? */
+    struct list_elem elem;      /* Element in frame list. */
+
+    /* Read-only file data shared through the file frame cache.
+       INODE is null if the frame never was in the cache. */
+    struct inode *inode;        /* Inode that data came from. */
+    off_t file_ofs;             /* Offset in INODE. */
+    size_t file_bytes;          /* Bytes read; rest is zeros. */
+    unsigned inode_version;     /* INODE's version when read. */
+    bool cached;                /* Still in the cache? */
+    bool inode_ref;             /* Keeps INODE open? */
+    struct hash_elem hash_elem; /* Element in file frame cache. */
+  };
+
+void frame_init (void);
+void frame_start_pageout (size_t low_pages, size_t high_pages);
+struct frame *frame_alloc (struct page *);
+struct frame *frame_try_alloc (struct page *);
+struct frame *frame_alloc_file (struct page *, struct inode *, off_t ofs,
+                                size_t bytes, bool *loaded);
+struct frame *frame_lookup_file (struct page *, struct inode *, off_t ofs,
+                                 size_t bytes);
+struct frame *frame_alloc_cached (struct inode *, off_t ofs, size_t bytes,
+                                  bool *cached);
+void frame_release (struct frame *, struct page *);
+void frame_share (struct frame *, struct page *);
+struct frame *frame_unshare (struct frame *, struct page *);
+struct frame *frame_pin (struct page *);
+void frame_unpin (struct frame *);
+void *frame_kmap (struct frame *);
+void frame_kunmap (struct frame *, const void *kaddr);
+
+#endif /* vm/frame.h */
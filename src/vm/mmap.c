@@ -0,0 +1,201 @@
+#include "vm/mmap.h"
+#include <debug.h>
+#include <round.h>
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/page.h"
+
+/* Memory-mapped files.
+
+   A mapping covers consecutive pages of a process's address
+   space with the contents of a file.  Its pages are ordinary
+   entries in the supplemental page table, of type PAGE_MMAP, so
+   they are read in lazily by the page fault handler like any
+   other file-backed page.  Unlike other pages, they are written
+   back to the file, rather than to swap, when they are evicted
+   and when the mapping is flushed or removed, but only if they
+   have actually been modified. */
+
+/* A memory-mapped file. */
+struct mapping
+  {
+    mapid_t id;                 /* Mapping identifier. */
+    struct file *file;          /* File, reopened for the mapping. */
+    uint8_t *base;              /* First mapped page. */
+    size_t page_cnt;            /* Number of mapped pages. */
+    struct list_elem elem;      /* Element in thread's `mappings'. */
+  };
+
+static struct mapping *lookup_mapping (mapid_t);
+static bool sync_mapping (struct mapping *);
+static void remove_mapping (struct mapping *, size_t page_cnt);
+
+/* Maps FILE into the running process's address space starting
+   at page-aligned user virtual address ADDR.  The mapping uses
+   its own reopened copy of FILE, so it is unaffected if FILE is
+   later closed.  Returns the new mapping's identifier, or
+   MAP_FAILED if FILE is empty, ADDR is null or misaligned, the
+   mapping would overlap pages already in use, or memory
+   allocation fails. */
+mapid_t
+mmap_map (struct file *file, void *addr)
+{
+  struct thread *t = thread_current ();
+  struct mapping *m;
+  off_t length;
+  size_t i;
+
+  if (addr == NULL || pg_ofs (addr) != 0)
+    return MAP_FAILED;
+
+  m = malloc (sizeof *m);
+  if (m == NULL)
+    return MAP_FAILED;
+
+  lock_acquire (&filesys_lock);
+  m->file = file_reopen (file);
+  length = m->file != NULL ? file_length (m->file) : 0;
+  lock_release (&filesys_lock);
+  if (length == 0)
+    goto error;
+
+  m->base = addr;
+  m->page_cnt = DIV_ROUND_UP (length, PGSIZE);
+  if (!is_user_vaddr (m->base + m->page_cnt * PGSIZE - 1)
+      || m->base + m->page_cnt * PGSIZE < m->base)
+    goto error;
+
+  for (i = 0; i < m->page_cnt; i++)
+    {
+      off_t ofs = i * PGSIZE;
+      size_t bytes = length - ofs < PGSIZE ? length - ofs : PGSIZE;
+
+      /* Pages mapped outside the supplemental page table, such as
+         shared memory segments and rings, are in use too. */
+      if (pagedir_get_phys (t->pagedir, m->base + ofs) != 0
+          || page_add_mmap (m->base + ofs, m->file, ofs, bytes) == NULL)
+        {
+          remove_mapping (m, i);
+          goto error;
+        }
+    }
+
+  m->id = t->next_mapid++;
+  list_push_back (&t->mappings, &m->elem);
+  return m->id;
+
+ error:
+  lock_acquire (&filesys_lock);
+  file_close (m->file);
+  lock_release (&filesys_lock);
+  free (m);
+  return MAP_FAILED;
+}
+
+/* Writes back the modified pages of mapping ID and removes it
+   from the running process's address space.  Returns true if
+   successful, false if ID is not one of the process's
+   mappings. */
+bool
+mmap_unmap (mapid_t id)
+{
+  struct mapping *m = lookup_mapping (id);
+
+  if (m == NULL)
+    return false;
+
+  sync_mapping (m);
+  list_remove (&m->elem);
+  remove_mapping (m, m->page_cnt);
+  lock_acquire (&filesys_lock);
+  file_close (m->file);
+  lock_release (&filesys_lock);
+  free (m);
+  return true;
+}
+
+/* Writes back the pages of mapping ID that have been modified
+   since they were read in or last written back.  Returns true if
+   successful, false if ID is not one of the running process's
+   mappings or a write fails. */
+bool
+mmap_sync (mapid_t id)
+{
+  struct mapping *m = lookup_mapping (id);
+
+  return m != NULL && sync_mapping (m);
+}
+
+/* Unmaps all of the running process's mappings, writing back
+   their modified pages.  Must be called before the process's
+   supplemental page table is destroyed. */
+void
+mmap_unmap_all (void)
+{
+  struct thread *t = thread_current ();
+
+  while (!list_empty (&t->mappings))
+    {
+      struct mapping *m = list_entry (list_front (&t->mappings),
+                                      struct mapping, elem);
+      mmap_unmap (m->id);
+    }
+}
+
+/* Returns the running process's mapping with identifier ID, or a
+   null pointer if there is none. */
+static struct mapping *
+lookup_mapping (mapid_t id)
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&t->mappings); e != list_end (&t->mappings);
+       e = list_next (e))
+    {
+      struct mapping *m = list_entry (e, struct mapping, elem);
+      if (m->id == id)
+        return m;
+    }
+  return NULL;
+}
+
+/* Writes back the modified pages of mapping M.  Returns true if
+   successful, false if a write fails. */
+static bool
+sync_mapping (struct mapping *m)
+{
+  bool success = true;
+  size_t i;
+
+  for (i = 0; i < m->page_cnt; i++)
+    {
+      struct page *p = page_lookup (m->base + i * PGSIZE);
+      if (p != NULL && !page_sync (p))
+        success = false;
+    }
+  return success;
+}
+
+/* Removes the first PAGE_CNT pages of mapping M from the running
+   process's address space, discarding their contents. */
+static void
+remove_mapping (struct mapping *m, size_t page_cnt)
+{
+  size_t i;
+
+  /* Unmap the whole range with a single TLB flush, so that
+     page_remove() finds each page already unmapped. */
+  pagedir_clear_range (thread_current ()->pagedir, m->base, page_cnt);
+  for (i = 0; i < page_cnt; i++)
+    {
+      struct page *p = page_lookup (m->base + i * PGSIZE);
+      if (p != NULL)
+        page_remove (p);
+    }
+}
@@ -0,0 +1,843 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/frame.h"
+#include "vm/readahead.h"
+#include "vm/swap.h"
+
+/* Supplemental page table.
+
+   Each process has a hash table, keyed on user virtual address,
+   that describes every page in its address space, whether or not
+   the page is currently resident.  Pages are created when a
+   program is loaded (or its stack grows) but no memory is
+   allocated for them until they are first touched, at which
+   point page_fault_in() brings them in.
+
+   A page's type says where its contents come from when it is
+   not resident.  Zero-fill and file-backed pages that have not
+   been modified can simply be dropped on eviction and recreated
+   later.  Once modified, a page becomes anonymous (PAGE_SWAP)
+   and has to be written to swap when it is evicted.  Pages of
+   memory-mapped files (PAGE_MMAP) are the exception: they are
+   written back to their file instead, if modified.
+
+   Zero-fill pages that are only read never get a frame at all.
+   A read fault maps them to a single, shared, read-only page of
+   zeros, and only a write makes page_copy_on_write() give them
+   a frame of their own.
+
+   Read-only file pages are shared among processes through the
+   frame table's file frame cache, so that running a program
+   many times costs one copy of its text.
+
+   fork() copies a process's supplemental page table rather than
+   its memory.  Resident pages end up sharing their frames, and
+   pages in swap share their slots, until either process writes
+   to them; see page_copy_on_write(). */
+
+/* Page of zeros mapped read-only in place of zero-fill pages
+   that have not been written. */
+static void *zero_page;
+
+/* System-wide memory statistics. */
+struct memstat vm_memstat;
+
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static void destroy_page (struct hash_elem *, void *aux);
+static struct page *page_add (void *upage, bool writable);
+static bool bring_in (struct page *, bool *major);
+static bool fault_in (struct page *);
+static bool load_page (struct page *, struct frame *);
+static bool swap_in_cluster (struct page *, struct frame *);
+static bool copy_page (struct page *, struct thread *parent);
+static bool is_stack_access (const void *addr, const void *esp);
+
+/* Initializes the supplemental page table module. */
+void
+page_init (void)
+{
+  zero_page = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+}
+
+/* Prints system-wide paging statistics. */
+void
+page_print_stats (void)
+{
+  printf ("Paging: %lu minor faults, %lu major faults, %lu COW copies, "
+          "%lu swap-ins, %lu swap-outs\n",
+          vm_memstat.minor_faults, vm_memstat.major_faults,
+          vm_memstat.cow_copies, vm_memstat.swap_ins, vm_memstat.swap_outs);
+}
+
+/* Creates an empty supplemental page table for the running
+   thread.  Returns true if successful, false on memory
+   allocation failure. */
+bool
+page_table_init (void)
+{
+  struct thread *t = thread_current ();
+
+  ASSERT (t->pages == NULL);
+  t->pages = malloc (sizeof *t->pages);
+  if (t->pages == NULL)
+    return false;
+  if (!hash_init (t->pages, page_hash, page_less, NULL))
+    {
+      free (t->pages);
+      t->pages = NULL;
+      return false;
+    }
+  return true;
+}
+
+/* Destroys the running thread's supplemental page table, if it
+   has one, freeing the frames and swap slots of its pages.
+   Resident pages are unmapped from the thread's page directory,
+   which must not have been destroyed yet. */
+void
+page_table_destroy (void)
+{
+  struct thread *t = thread_current ();
+
+  if (t->pages != NULL)
+    {
+      hash_destroy (t->pages, destroy_page);
+      free (t->pages);
+      t->pages = NULL;
+    }
+}
+
+/* Fills the running thread's empty supplemental page table with
+   a copy-on-write copy of PARENT's, for fork().  Resident pages
+   of PARENT are shared with the running thread, read-only in
+   both processes until one of them writes to it.  PARENT must
+   stay blocked until we are done.  Returns true if successful,
+   false on memory allocation failure, in which case the table
+   may be partially filled in. */
+bool
+page_table_copy (struct thread *parent)
+{
+  struct hash_iterator i;
+
+  ASSERT (parent->pages != NULL);
+
+  hash_first (&i, parent->pages);
+  while (hash_next (&i))
+    {
+      struct page *p = hash_entry (hash_cur (&i), struct page, hash_elem);
+
+      /* Memory-mapped files are not inherited. */
+      if (p->type != PAGE_MMAP && !copy_page (p, parent))
+        return false;
+    }
+  return true;
+}
+
+/* Adds a page at user virtual address UPAGE to the running
+   thread's address space that is initially all zeros.  If
+   WRITABLE is true, the user process may modify the page;
+   otherwise, it is read-only.  Returns the new page, or a null
+   pointer if UPAGE is already in use or memory allocation
+   fails. */
+struct page *
+page_add_zero (void *upage, bool writable)
+{
+  return page_add (upage, writable);
+}
+
+/* Adds a page at user virtual address UPAGE to the running
+   thread's address space whose first FILE_BYTES bytes are read
+   from FILE starting at offset OFS, with the rest of the page
+   zeroed.  If WRITABLE is true, the user process may modify the
+   page; otherwise, it is read-only.  Nothing is read until the
+   page is first accessed.  Returns the new page, or a null
+   pointer if UPAGE is already in use or memory allocation
+   fails. */
+struct page *
+page_add_file (void *upage, struct file *file, off_t ofs,
+               size_t file_bytes, bool writable)
+{
+  struct page *p;
+
+  ASSERT (file != NULL);
+  ASSERT (file_bytes <= PGSIZE);
+
+  p = page_add (upage, writable);
+  if (p != NULL)
+    {
+      p->type = PAGE_FILE;
+      p->file = file;
+      p->file_ofs = ofs;
+      p->file_bytes = file_bytes;
+    }
+  return p;
+}
+
+/* Adds a page at user virtual address UPAGE to the running
+   thread's address space that maps FILE_BYTES bytes of FILE
+   starting at offset OFS, with the rest of the page zeroed.
+   Nothing is read until the page is first accessed.  Unlike
+   other file-backed pages, the page is writable, and changes to
+   it are written back to FILE.  Returns the new page, or a null
+   pointer if UPAGE is already in use or memory allocation
+   fails. */
+struct page *
+page_add_mmap (void *upage, struct file *file, off_t ofs,
+               size_t file_bytes)
+{
+  struct page *p = page_add_file (upage, file, ofs, file_bytes, true);
+
+  if (p != NULL)
+    p->type = PAGE_MMAP;
+  return p;
+}
+
+/* Removes page P from the running thread's address space,
+   discarding its contents. */
+void
+page_remove (struct page *p)
+{
+  struct thread *t = thread_current ();
+
+  ASSERT (p->thread == t);
+  hash_delete (t->pages, &p->hash_elem);
+  destroy_page (&p->hash_elem, NULL);
+}
+
+/* Returns the page in the running thread's address space that
+   contains user virtual address ADDR, or a null pointer if there
+   is no such page. */
+struct page *
+page_lookup (const void *addr)
+{
+  struct thread *t = thread_current ();
+  struct page p;
+  struct hash_elem *e;
+
+  if (t->pages == NULL)
+    return NULL;
+
+  p.addr = pg_round_down (addr);
+  e = hash_find (t->pages, &p.hash_elem);
+  return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+}
+
+/* Brings page P into memory, if it is not already resident, and
+   maps it into its thread's page directory.  Returns true if
+   successful, false if memory allocation or a file read
+   fails. */
+bool
+page_in (struct page *p)
+{
+  bool major;
+
+  return bring_in (p, &major);
+}
+
+/* Does the work of page_in() for page P, setting *MAJOR to true
+   if that involved reading a file or swap, false otherwise. */
+static bool
+bring_in (struct page *p, bool *major)
+{
+  uint32_t *pd = p->thread->pagedir;
+  struct frame *f;
+  bool loaded = false;
+  bool success;
+
+  *major = false;
+  f = frame_pin (p);
+  if (f != NULL)
+    {
+      /* Already resident, but not necessarily mapped: see
+         swap_in_cluster(). */
+      success = (pagedir_get_phys (pd, p->addr) != 0
+                 || pagedir_set_phys (pd, p->addr, f->paddr,
+                                      p->writable && f->ref_cnt == 1));
+      frame_unpin (f);
+      return success;
+    }
+
+  /* Stop using the zero page, if we were. */
+  if (pagedir_get_phys (pd, p->addr) == vtop (zero_page))
+    pagedir_clear_page (pd, p->addr);
+
+  /* Read-only file pages, such as program text, are shared by
+     every process that maps the same part of the same file. */
+  if (p->type == PAGE_FILE && !p->writable)
+    f = frame_alloc_file (p, file_get_inode (p->file), p->file_ofs,
+                          p->file_bytes, &loaded);
+  else
+    f = frame_alloc (p);
+  if (f == NULL)
+    return false;
+  if (p->type == PAGE_SWAP && p->swap_slot != SWAP_ERROR)
+    {
+      *major = true;
+      return swap_in_cluster (p, f);
+    }
+  if (!loaded && p->type != PAGE_ZERO && p->type != PAGE_SWAP)
+    *major = true;
+  if ((!loaded && !load_page (p, f))
+      || !pagedir_set_phys (pd, p->addr, f->paddr, p->writable))
+    {
+      frame_release (f, p);
+      return false;
+    }
+  frame_unpin (f);
+  return true;
+}
+
+/* Maps page P, a read-only page of a file that is not resident,
+   to the frame in the file frame cache that already holds its
+   contents, if there is one.  Never reads, waits or evicts
+   anything.  Returns true if successful. */
+bool
+page_map_cached (struct page *p)
+{
+  struct frame *f;
+
+  ASSERT (p->type == PAGE_FILE && !p->writable);
+
+  f = frame_lookup_file (p, file_get_inode (p->file), p->file_ofs,
+                         p->file_bytes);
+  if (f == NULL)
+    return false;
+  if (!pagedir_set_phys (p->thread->pagedir, p->addr, f->paddr, false))
+    {
+      frame_release (f, p);
+      return false;
+    }
+  frame_unpin (f);
+  return true;
+}
+
+/* Reads page P, which must be neither resident nor in swap, into
+   a frame and maps it, unless that would require evicting other
+   pages.  Returns true if successful. */
+bool
+page_prefetch (struct page *p)
+{
+  struct frame *f;
+
+  ASSERT (p->swap_slot == SWAP_ERROR);
+
+  f = frame_try_alloc (p);
+  if (f == NULL)
+    return false;
+  if (!load_page (p, f)
+      || !pagedir_set_phys (p->thread->pagedir, p->addr, f->paddr,
+                            p->writable))
+    {
+      frame_release (f, p);
+      return false;
+    }
+  frame_unpin (f);
+  return true;
+}
+
+/* Handles a write fault at FAULT_ADDR on a present, read-only
+   page in the running thread's address space.  If the page is
+   writable but shares its frame with other processes since a
+   fork(), gives it a private copy of the frame (unless it is
+   the last one left sharing it) and maps it writable.  If it is
+   a zero-fill page mapped to the shared zero page, gives it a
+   frame of its own.  Returns
+   true if the faulting access can be restarted, false if it was
+   invalid or memory ran out. */
+bool
+page_copy_on_write (void *fault_addr)
+{
+  struct page *p;
+  struct frame *f, *copy;
+  uint32_t *pd;
+
+  if (!is_user_vaddr (fault_addr))
+    return false;
+  p = page_lookup (fault_addr);
+  if (p == NULL || !p->writable)
+    return false;
+
+  /* Mapped to the zero page, or evicted since the fault.
+     Either way, page_in() gives it a frame of its own. */
+  f = frame_pin (p);
+  if (f == NULL)
+    return fault_in (p);
+
+  copy = frame_unshare (f, p);
+  if (copy == NULL)
+    {
+      frame_unpin (f);
+      return false;
+    }
+  MEMSTAT_ADD (p->thread, minor_faults, 1);
+  if (copy != f)
+    MEMSTAT_ADD (p->thread, cow_copies, 1);
+
+  pd = p->thread->pagedir;
+  if (copy == f)
+    pagedir_set_writable (pd, p->addr, true);
+  else
+    {
+      pagedir_clear_page (pd, p->addr);
+      if (!pagedir_set_phys (pd, p->addr, copy->paddr, true))
+        NOT_REACHED ();
+    }
+  frame_unpin (copy);
+  return true;
+}
+
+/* Records that page P has been modified since it was loaded,
+   according to the dirty bit in a mapping of P that is going
+   away.  P's contents can no longer be recreated from its
+   original source. */
+void
+page_mark_dirty (struct page *p)
+{
+  if (p->type == PAGE_MMAP)
+    p->dirty = true;
+  else
+    p->type = PAGE_SWAP;
+}
+
+/* Returns true if page P has to be written to swap when it is
+   evicted, because it is anonymous.  Otherwise, its contents can
+   be recreated and it can simply be dropped.  Whoever unmaps P
+   for eviction must call page_mark_dirty() first, if P's
+   mapping was dirty. */
+bool
+page_needs_swap (const struct page *p)
+{
+  return p->type == PAGE_SWAP;
+}
+
+/* Returns true if page P is a page of a memory-mapped file that
+   has to be written back to the file before it can be evicted.
+   Whoever unmaps P for eviction must call page_mark_dirty()
+   first, if P's mapping was dirty. */
+bool
+page_needs_write_back (const struct page *p)
+{
+  return p->type == PAGE_MMAP && p->dirty;
+}
+
+/* Writes KPAGE, which holds the contents of page P of a
+   memory-mapped file, back to the file.  Returns true if
+   successful, false if the write fails. */
+bool
+page_write_back (struct page *p, const void *kpage)
+{
+  off_t written;
+
+  ASSERT (p->type == PAGE_MMAP);
+
+  lock_acquire (&filesys_lock);
+  written = file_write_at (p->file, kpage, p->file_bytes, p->file_ofs);
+  lock_release (&filesys_lock);
+  if (written != (off_t) p->file_bytes)
+    return false;
+  p->dirty = false;
+  return true;
+}
+
+/* Writes page P of a memory-mapped file back to the file if it
+   has been modified since it was read in or last written back.
+   A page that is not resident has nothing to write, because
+   eviction writes back modified pages.  Returns true if
+   successful, false if the write fails. */
+bool
+page_sync (struct page *p)
+{
+  uint32_t *pd = p->thread->pagedir;
+  struct frame *f;
+  bool success = true;
+
+  ASSERT (p->type == PAGE_MMAP);
+
+  f = frame_pin (p);
+  if (f != NULL)
+    {
+      /* Clear the dirty bit before writing, so that a write to
+         the page that races with us dirties it again. */
+      if (pagedir_is_dirty (pd, p->addr))
+        {
+          pagedir_set_dirty (pd, p->addr, false);
+          p->dirty = true;
+        }
+      if (p->dirty)
+        {
+          void *kaddr = frame_kmap (f);
+          success = page_write_back (p, kaddr);
+          frame_kunmap (f, kaddr);
+        }
+      frame_unpin (f);
+    }
+  return success;
+}
+
+/* Records that page P, which is being evicted, has been written
+   to swap slot SLOT.  Called by the frame table before P is
+   detached from its frame. */
+void
+page_swapped_out (struct page *p, size_t slot)
+{
+  p->type = PAGE_SWAP;
+  p->swap_slot = slot;
+  swap_set_owner (slot, p->thread, p->addr);
+  MEMSTAT_ADD (p->thread, swap_outs, 1);
+}
+
+/* Tries to resolve a page fault at FAULT_ADDR in the running
+   thread's address space by bringing in the page that contains
+   it.  WRITE is true if the faulting access was a write.  ESP
+   is the user stack pointer at the time of the fault, used to
+   recognize accesses that should grow the stack, or a null
+   pointer if it is not known.  Returns true if the faulting
+   access can be restarted, false if it was invalid. */
+bool
+page_fault_in (void *fault_addr, bool write, void *esp)
+{
+  struct page *p;
+
+  if (!is_user_vaddr (fault_addr) || thread_current ()->pages == NULL)
+    return false;
+
+  p = page_lookup (fault_addr);
+  if (p == NULL)
+    {
+      if (!is_stack_access (fault_addr, esp))
+        return false;
+      p = page_add_zero (pg_round_down (fault_addr), true);
+      if (p == NULL)
+        return false;
+    }
+
+  /* Reading a zero-fill page doesn't need a frame. */
+  if (!write && p->type == PAGE_ZERO && p->frame == NULL)
+    {
+      MEMSTAT_ADD (p->thread, minor_faults, 1);
+      return pagedir_set_page (p->thread->pagedir, p->addr, zero_page,
+                               false);
+    }
+
+  if (!fault_in (p))
+    return false;
+  if (p->type == PAGE_MMAP || (p->type == PAGE_FILE && !p->writable))
+    readahead_fault (p);
+  return true;
+}
+
+/* Brings in the page that contains user address ADDR in the
+   running thread's address space, as if the process had
+   accessed it, and pins its frame, so that the kernel can reach
+   the page through the frame, without faulting, until it calls
+   frame_unpin().  If WRITE is true, the page must be writable;
+   it gets a frame of its own if it was sharing one and is
+   marked dirty, because the kernel's writes through the frame
+   do not set the dirty bit in the process's page table.
+   Returns the pinned frame, or a null pointer if ADDR is not
+   valid for the access or memory runs out. */
+struct frame *
+page_pin (const void *addr, bool write)
+{
+  uint32_t *pd = thread_current ()->pagedir;
+  void *upage = pg_round_down (addr);
+
+  for (;;)
+    {
+      struct page *p = page_lookup (addr);
+      struct frame *f;
+
+      /* A page that doesn't exist yet might be stack growth. */
+      if (p == NULL)
+        {
+          if (!page_fault_in (upage, write, thread_current ()->user_esp))
+            return NULL;
+          continue;
+        }
+      if (write && !p->writable)
+        return NULL;
+
+      /* Bring it in and map it, unless it already is.  A page
+         mapped to the zero page has no frame, so this gives it
+         one. */
+      f = frame_pin (p);
+      if (f == NULL || pagedir_get_phys (pd, upage) != f->paddr)
+        {
+          if (f != NULL)
+            frame_unpin (f);
+          if (!fault_in (p))
+            return NULL;
+          continue;
+        }
+
+      if (!write)
+        return f;
+      if (pagedir_is_writable (pd, upage))
+        {
+          pagedir_set_dirty (pd, upage, true);
+          return f;
+        }
+
+      /* Shared copy-on-write. */
+      frame_unpin (f);
+      if (!page_copy_on_write (upage))
+        return NULL;
+    }
+}
+
+/* Brings in page P to resolve a page fault, counting the fault
+   as minor or major.  Returns true if successful, false if
+   memory allocation or a read fails. */
+static bool
+fault_in (struct page *p)
+{
+  bool major;
+
+  if (!bring_in (p, &major))
+    return false;
+  if (major)
+    MEMSTAT_ADD (p->thread, major_faults, 1);
+  else
+    MEMSTAT_ADD (p->thread, minor_faults, 1);
+  return true;
+}
+
+/* Returns a hash value for the page that E refers to. */
+static unsigned
+page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct page *p = hash_entry (e, struct page, hash_elem);
+  return hash_bytes (&p->addr, sizeof p->addr);
+}
+
+/* Returns true if page A precedes page B. */
+static bool
+page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+           void *aux UNUSED)
+{
+  const struct page *a = hash_entry (a_, struct page, hash_elem);
+  const struct page *b = hash_entry (b_, struct page, hash_elem);
+  return a->addr < b->addr;
+}
+
+/* Frees the page that E refers to, along with its frame or swap
+   slot. */
+static void
+destroy_page (struct hash_elem *e, void *aux UNUSED)
+{
+  struct page *p = hash_entry (e, struct page, hash_elem);
+  struct frame *f = frame_pin (p);
+
+  if (f != NULL)
+    {
+      pagedir_clear_page (p->thread->pagedir, p->addr);
+      frame_release (f, p);
+    }
+  else if (pagedir_get_phys (p->thread->pagedir, p->addr)
+           == vtop (zero_page))
+    {
+      /* Don't let pagedir_destroy() free the zero page. */
+      pagedir_clear_page (p->thread->pagedir, p->addr);
+    }
+  else if (p->type == PAGE_SWAP && p->swap_slot != SWAP_ERROR)
+    swap_free (p->swap_slot);
+  free (p);
+}
+
+/* Creates a zero-filled page at UPAGE in the running thread's
+   supplemental page table and returns it, or returns a null
+   pointer if UPAGE is already in use or memory allocation
+   fails. */
+static struct page *
+page_add (void *upage, bool writable)
+{
+  struct thread *t = thread_current ();
+  struct page *p;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (t->pages != NULL);
+
+  p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+
+  p->addr = upage;
+  p->thread = t;
+  p->writable = writable;
+  p->type = PAGE_ZERO;
+  p->frame = NULL;
+  p->file = NULL;
+  p->file_ofs = 0;
+  p->file_bytes = 0;
+  p->dirty = false;
+  p->swap_slot = SWAP_ERROR;
+
+  if (hash_insert (t->pages, &p->hash_elem) != NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  return p;
+}
+
+/* Fills F, which is P's pinned frame, with the contents of page
+   P, which must not be in swap.  Returns true if successful,
+   false if a file read fails. */
+static bool
+load_page (struct page *p, struct frame *f)
+{
+  void *kpage;
+  size_t zero_ofs = 0;
+  bool success = true;
+
+  ASSERT (p->swap_slot == SWAP_ERROR);
+
+  kpage = frame_kmap (f);
+
+  /* An anonymous page that has never been evicted is zeros. */
+  if (p->type == PAGE_FILE || p->type == PAGE_MMAP)
+    {
+      off_t read;
+
+      lock_acquire (&filesys_lock);
+      read = file_read_at (p->file, kpage, p->file_bytes, p->file_ofs);
+      lock_release (&filesys_lock);
+      if (read != (off_t) p->file_bytes)
+        success = false;
+      zero_ofs = p->file_bytes;
+    }
+  if (success)
+    memset ((uint8_t *) kpage + zero_ofs, 0, PGSIZE - zero_ofs);
+  frame_kunmap (f, kpage);
+  return success;
+}
+
+/* Reads page P, which is in swap, into F, which is P's newly
+   allocated frame, and maps it.
+
+   Also reads ahead.  Pages of the same process in the slots
+   that follow P's were most likely evicted in the same cluster
+   as P, so as many of them as there are free frames for are
+   read by the same disk request and mapped as well.  Such a
+   page is left resident but unmapped if mapping it fails, and
+   page_in() maps it when it is next touched.
+
+   Returns true if successful, false if P cannot be mapped. */
+static bool
+swap_in_cluster (struct page *p, struct frame *f)
+{
+  struct page *pages[SWAP_CLUSTER_PAGES];
+  struct frame *frames[SWAP_CLUSTER_PAGES];
+  void *kpages[SWAP_CLUSTER_PAGES];
+  size_t slot = p->swap_slot;
+  bool success = true;
+  size_t cnt, i;
+
+  pages[0] = p;
+  frames[0] = f;
+  kpages[0] = frame_kmap (f);
+  for (cnt = 1; cnt < SWAP_CLUSTER_PAGES; cnt++)
+    {
+      void *upage = swap_owner (slot + cnt, p->thread);
+      struct page *q = upage != NULL ? page_lookup (upage) : NULL;
+
+      if (q == NULL || (frames[cnt] = frame_try_alloc (q)) == NULL)
+        break;
+      if (q->type != PAGE_SWAP || q->swap_slot != slot + cnt)
+        {
+          frame_release (frames[cnt], q);
+          break;
+        }
+      pages[cnt] = q;
+      kpages[cnt] = frame_kmap (frames[cnt]);
+    }
+
+  swap_read (slot, kpages, cnt);
+  MEMSTAT_ADD (p->thread, swap_ins, cnt);
+  for (i = 0; i < cnt; i++)
+    {
+      struct page *q = pages[i];
+
+      q->swap_slot = SWAP_ERROR;
+      frame_kunmap (frames[i], kpages[i]);
+      if (!pagedir_set_phys (q->thread->pagedir, q->addr, frames[i]->paddr,
+                             q->writable)
+          && q == p)
+        success = false;
+      frame_unpin (frames[i]);
+    }
+  return success;
+}
+
+/* Adds a copy of page P from PARENT's supplemental page table to
+   the running thread's, as part of page_table_copy().  Returns
+   true if successful, false on memory allocation failure. */
+static bool
+copy_page (struct page *p, struct thread *parent)
+{
+  struct thread *cur = thread_current ();
+  struct page *q;
+  struct frame *f;
+
+  q = page_add (p->addr, p->writable);
+  if (q == NULL)
+    return false;
+  q->file = p->file == parent->exec_file ? cur->exec_file : p->file;
+  q->file_ofs = p->file_ofs;
+  q->file_bytes = p->file_bytes;
+
+  f = frame_pin (p);
+  if (f != NULL)
+    {
+      /* Changes the parent has made to the page must survive,
+         so fold its dirty bit into the page's type before the
+         parent loses write access to it. */
+      if (pagedir_is_dirty (parent->pagedir, p->addr))
+        page_mark_dirty (p);
+      q->type = p->type;
+      if (p->writable)
+        pagedir_set_writable (parent->pagedir, p->addr, false);
+      if (!pagedir_set_phys (cur->pagedir, q->addr, f->paddr, false))
+        {
+          frame_unpin (f);
+          return false;
+        }
+      frame_share (f, q);
+      frame_unpin (f);
+    }
+  else
+    {
+      q->type = p->type;
+      if (p->type == PAGE_SWAP && p->swap_slot != SWAP_ERROR)
+        {
+          swap_dup (p->swap_slot);
+          q->swap_slot = p->swap_slot;
+        }
+    }
+  return true;
+}
+
+/* Returns true if an access to ADDR, made while the user stack
+   pointer was ESP, should be treated as growing the stack.  The
+   80x86 PUSHA instruction checks access permissions up to 32
+   bytes below the stack pointer before moving it, so such
+   accesses count too. */
+static bool
+is_stack_access (const void *addr, const void *esp)
+{
+  return (esp != NULL
+          && (uint8_t *) addr >= (uint8_t *) PHYS_BASE - STACK_MAX
+          && (uint8_t *) addr >= (uint8_t *) esp - 32);
+}
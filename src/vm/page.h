@@ -0,0 +1,88 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <list.h>
+#include <memstat.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+
+/* Maximum size of a process's stack, in bytes. */
+#define STACK_MAX (8 * 1024 * 1024)
+
+/* Where a page's contents come from when it is not resident. */
+enum page_type
+  {
+    PAGE_ZERO,                  /* All zeros. */
+    PAGE_FILE,                  /* Read from a file, rest zeroed. */
+    PAGE_SWAP,                  /* Anonymous, in swap when evicted. */
+    PAGE_MMAP                   /* Memory-mapped file, written back. */
+  };
+
+/* A page of user virtual memory, as recorded in the owning
+   process's supplemental page table.
+
+   The hardware page table only describes pages that are
+   resident.  This structure also describes pages that have not
+   been loaded yet, so that the page fault handler knows how to
+   bring them in. */
+struct page
+  {
+    void *addr;                 /* User virtual address. */
+    struct thread *thread;      /* Owning thread. */
+    bool writable;              /* Read/write or read-only? */
+    enum page_type type;        /* Source of page's contents. */
+    struct frame *frame;        /* Frame, if resident. */
+    struct list_elem frame_elem; /* Element in frame's `pages'. */
+    struct hash_elem hash_elem; /* Element in thread's `pages'. */
+
+    /* PAGE_FILE and PAGE_MMAP only. */
+    struct file *file;          /* File to read. */
+    off_t file_ofs;             /* Offset in FILE. */
+    size_t file_bytes;          /* Bytes to read, at most PGSIZE. */
+
+    /* PAGE_MMAP only. */
+    bool dirty;                 /* Modified since last written back? */
+
+    /* PAGE_SWAP only. */
+    size_t swap_slot;           /* Swap slot, if not resident. */
+  };
+
+struct thread;
+
+/* System-wide totals of every process's memory statistics. */
+extern struct memstat vm_memstat;
+
+/* Adds N to memory statistic FIELD of thread T and to the
+   system-wide total. */
+#define MEMSTAT_ADD(T, FIELD, N)                        \
+        ((T)->memstat.FIELD += (N), vm_memstat.FIELD += (N))
+
+void page_init (void);
+void page_print_stats (void);
+bool page_table_init (void);
+void page_table_destroy (void);
+bool page_table_copy (struct thread *parent);
+
+struct page *page_add_zero (void *upage, bool writable);
+struct page *page_add_file (void *upage, struct file *, off_t ofs,
+                            size_t file_bytes, bool writable);
+struct page *page_add_mmap (void *upage, struct file *, off_t ofs,
+                            size_t file_bytes);
+void page_remove (struct page *);
+struct page *page_lookup (const void *addr);
+bool page_in (struct page *);
+bool page_map_cached (struct page *);
+bool page_prefetch (struct page *);
+bool page_copy_on_write (void *fault_addr);
+void page_mark_dirty (struct page *);
+bool page_needs_swap (const struct page *);
+bool page_needs_write_back (const struct page *);
+bool page_write_back (struct page *, const void *kpage);
+bool page_sync (struct page *);
+void page_swapped_out (struct page *, size_t slot);
+bool page_fault_in (void *fault_addr, bool write, void *esp);
+struct frame *page_pin (const void *addr, bool write);
+
+#endif /* vm/page.h */
@@ -0,0 +1,344 @@
+#include "vm/readahead.h"
+#include <debug.h>
+#include <list.h>
+#include <stdint.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/frame.h"
+#include "vm/page.h"
+
+/* Fault-around and readahead for file-backed pages.
+
+   Every process keeps track of a few "streams", one per file it
+   has mapped recently, remembering where in its address space
+   it expects the next fault on that file.  A fault there is
+   sequential, and doubles the stream's readahead window, up to
+   RA_MAX_PAGES; any other fault on the file halves it.
+
+   After a fault on a read-only page of a file, such as program
+   text, the pages that follow it and whose contents are already
+   in the file frame cache are mapped as well ("fault-around"),
+   so that the process doesn't fault on them one at a time.
+   Then, if the window is open, the pages after those are read
+   into the file frame cache by a background thread, so that
+   they are there for the next fault-around.
+
+   Pages of memory-mapped files are private to their process,
+   so no other thread can fill them in for it.  For those, the
+   faulting thread reads the pages in the window itself, as long
+   as there are free frames for them.
+
+   Readahead never evicts anything: it is only worth doing with
+   memory to spare. */
+
+/* Number of streams tracked per process. */
+#define RA_STREAMS 4
+
+/* Readahead window after the first sequential fault, and the
+   most it can grow to, in pages. */
+#define RA_INIT_PAGES 4
+#define RA_MAX_PAGES 32
+
+/* Most cached pages to map after a single fault. */
+#define FAULT_AROUND_PAGES 16
+
+/* Most readahead requests queued at once.  Beyond that, new
+   ones are dropped. */
+#define RA_MAX_REQUESTS 16
+
+/* Sequential access to one file by one process. */
+struct stream
+  {
+    struct file *file;          /* File, or null if unused. */
+    uint8_t *next;              /* Expected address of next fault. */
+    uint8_t *ra_end;            /* End of pages already read ahead. */
+    size_t window;              /* Readahead window, in pages. */
+  };
+
+/* A process's streams.  Owned by the process. */
+struct readahead
+  {
+    struct stream streams[RA_STREAMS];
+    unsigned hand;              /* Next stream to replace. */
+  };
+
+/* A request to read part of a file into the file frame cache. */
+struct ra_request
+  {
+    struct inode *inode;        /* Inode to read, kept open. */
+    size_t page_cnt;            /* Number of pages to read. */
+    off_t ofs[RA_MAX_PAGES];    /* Offset of each page. */
+    size_t bytes[RA_MAX_PAGES]; /* Bytes to read in each page. */
+    struct list_elem elem;      /* Element in `requests'. */
+  };
+
+/* Queued requests, protected by requests_lock. */
+static struct list requests;
+static size_t request_cnt;
+static struct lock requests_lock;
+static struct condition requests_cond;
+
+static struct stream *get_stream (struct readahead *, struct file *);
+static uint8_t *fault_around (struct page *);
+static uint8_t *read_ahead (struct page *, uint8_t *start, uint8_t *end);
+static void queue_request (struct ra_request *);
+static thread_func readahead_daemon NO_RETURN;
+
+/* Starts the readahead thread. */
+void
+readahead_init (void)
+{
+  list_init (&requests);
+  lock_init (&requests_lock);
+  cond_init (&requests_cond);
+  thread_create ("readaheadd", PRI_DEFAULT, readahead_daemon, NULL);
+}
+
+/* Called after page P, a page of a file that was not resident,
+   has been brought in to resolve a fault in the running
+   process.  Updates the process's stream for P's file, maps
+   neighboring pages that are already cached, and reads ahead if
+   the fault was sequential. */
+void
+readahead_fault (struct page *p)
+{
+  struct thread *t = thread_current ();
+  struct stream *s;
+  uint8_t *upage = p->addr;
+  uint8_t *end;
+
+  ASSERT (p->thread == t);
+  ASSERT (p->type == PAGE_MMAP || (p->type == PAGE_FILE && !p->writable));
+
+  if (t->readahead == NULL)
+    {
+      t->readahead = calloc (1, sizeof *t->readahead);
+      if (t->readahead == NULL)
+        return;
+    }
+  s = get_stream (t->readahead, p->file);
+
+  if (upage == s->next)
+    {
+      s->window = s->window == 0 ? RA_INIT_PAGES : s->window * 2;
+      if (s->window > RA_MAX_PAGES)
+        s->window = RA_MAX_PAGES;
+    }
+  else
+    {
+      s->window /= 2;
+      s->ra_end = NULL;
+    }
+
+  if (p->type == PAGE_FILE)
+    {
+      /* The fault-around pages are read ahead already, so the
+         window starts where they end. */
+      end = fault_around (p);
+      s->next = end;
+      if (s->ra_end < end || s->ra_end > end + RA_MAX_PAGES * PGSIZE)
+        s->ra_end = end;
+      if (s->window > 0 && s->ra_end < end + s->window * PGSIZE)
+        s->ra_end = read_ahead (p, s->ra_end, end + s->window * PGSIZE);
+    }
+  else
+    {
+      end = upage + PGSIZE;
+      while (end < upage + (s->window + 1) * PGSIZE)
+        {
+          struct page *q = page_lookup (end);
+          if (q == NULL || q->type != PAGE_MMAP || q->file != p->file
+              || q->frame != NULL || !page_prefetch (q))
+            break;
+          end += PGSIZE;
+        }
+      s->next = end;
+    }
+}
+
+/* Frees the running process's readahead state. */
+void
+readahead_exit (void)
+{
+  struct thread *t = thread_current ();
+
+  free (t->readahead);
+  t->readahead = NULL;
+}
+
+/* Returns RA's stream for FILE, replacing an old stream with a
+   new, empty one if there is none. */
+static struct stream *
+get_stream (struct readahead *ra, struct file *file)
+{
+  struct stream *s;
+  size_t i;
+
+  for (i = 0; i < RA_STREAMS; i++)
+    if (ra->streams[i].file == file)
+      return &ra->streams[i];
+
+  s = &ra->streams[ra->hand++ % RA_STREAMS];
+  s->file = file;
+  s->next = NULL;
+  s->ra_end = NULL;
+  s->window = 0;
+  return s;
+}
+
+/* Returns true if Q is a page that P's stream could read ahead:
+   a read-only page of the same file, not resident. */
+static bool
+same_stream (const struct page *p, const struct page *q)
+{
+  return (q != NULL && q->type == PAGE_FILE && !q->writable
+          && q->file == p->file && q->frame == NULL && q->file_bytes > 0);
+}
+
+/* Maps the pages that follow P, as long as they belong to P's
+   stream and are in the file frame cache.  Returns the address
+   just past the last page mapped, or just past P if none is. */
+static uint8_t *
+fault_around (struct page *p)
+{
+  uint8_t *upage = (uint8_t *) p->addr + PGSIZE;
+  size_t i;
+
+  for (i = 0; i < FAULT_AROUND_PAGES && is_user_vaddr (upage); i++)
+    {
+      struct page *q = page_lookup (upage);
+      if (!same_stream (p, q) || !page_map_cached (q))
+        break;
+      upage += PGSIZE;
+    }
+  return upage;
+}
+
+/* Queues a request to read the pages of P's stream from START up
+   to END into the file frame cache, stopping early at a page that
+   doesn't belong to the stream.  Returns the address just past
+   the last page requested. */
+static uint8_t *
+read_ahead (struct page *p, uint8_t *start, uint8_t *end)
+{
+  struct ra_request *r;
+  uint8_t *upage;
+
+  r = malloc (sizeof *r);
+  if (r == NULL)
+    return start;
+
+  r->page_cnt = 0;
+  for (upage = start; upage < end && is_user_vaddr (upage);
+       upage += PGSIZE)
+    {
+      struct page *q = page_lookup (upage);
+      if (!same_stream (p, q))
+        break;
+      r->ofs[r->page_cnt] = q->file_ofs;
+      r->bytes[r->page_cnt] = q->file_bytes;
+      r->page_cnt++;
+    }
+  if (r->page_cnt == 0)
+    {
+      free (r);
+      return upage;
+    }
+
+  lock_acquire (&filesys_lock);
+  r->inode = inode_reopen (file_get_inode (p->file));
+  lock_release (&filesys_lock);
+  queue_request (r);
+  return upage;
+}
+
+/* Hands R to the readahead thread, or drops it if too many
+   requests are queued already. */
+static void
+queue_request (struct ra_request *r)
+{
+  bool queued = false;
+
+  lock_acquire (&requests_lock);
+  if (request_cnt < RA_MAX_REQUESTS)
+    {
+      list_push_back (&requests, &r->elem);
+      request_cnt++;
+      cond_signal (&requests_cond, &requests_lock);
+      queued = true;
+    }
+  lock_release (&requests_lock);
+
+  if (!queued)
+    {
+      lock_acquire (&filesys_lock);
+      inode_close (r->inode);
+      lock_release (&filesys_lock);
+      free (r);
+    }
+}
+
+/* Readahead thread.  Reads the pages in each queued request into
+   the file frame cache, giving up on a request when free frames
+   run short. */
+static void
+readahead_daemon (void *aux UNUSED)
+{
+  for (;;)
+    {
+      struct ra_request *r;
+      size_t i;
+
+      lock_acquire (&requests_lock);
+      while (list_empty (&requests))
+        cond_wait (&requests_cond, &requests_lock);
+      r = list_entry (list_pop_front (&requests), struct ra_request, elem);
+      request_cnt--;
+      lock_release (&requests_lock);
+
+      for (i = 0; i < r->page_cnt; i++)
+        {
+          struct frame *f;
+          struct inode *inode;
+          bool cached;
+          void *kpage;
+          off_t read;
+
+          lock_acquire (&filesys_lock);
+          inode = inode_reopen (r->inode);
+          lock_release (&filesys_lock);
+
+          f = frame_alloc_cached (inode, r->ofs[i], r->bytes[i], &cached);
+          if (f == NULL)
+            {
+              lock_acquire (&filesys_lock);
+              inode_close (inode);
+              lock_release (&filesys_lock);
+              if (cached)
+                continue;
+              break;
+            }
+
+          kpage = frame_kmap (f);
+          lock_acquire (&filesys_lock);
+          read = inode_read_at (inode, kpage, r->bytes[i], r->ofs[i]);
+          lock_release (&filesys_lock);
+          if (read < 0)
+            read = 0;
+          memset ((uint8_t *) kpage + read, 0, PGSIZE - read);
+          frame_kunmap (f, kpage);
+          frame_unpin (f);
+        }
+
+      lock_acquire (&filesys_lock);
+      inode_close (r->inode);
+      lock_release (&filesys_lock);
+      free (r);
+    }
+}
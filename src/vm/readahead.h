@@ -0,0 +1,10 @@
+#ifndef VM_READAHEAD_H
+#define VM_READAHEAD_H
+
+struct page;
+
+void readahead_init (void);
+void readahead_fault (struct page *);
+void readahead_exit (void);
+
+#endif /* vm/readahead.h */
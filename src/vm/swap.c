@@ -0,0 +1,311 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "devices/block.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/zswap.h"
+
+/* Swap space.
+
+   The swap device is divided into page-size "slots", each of
+   which can hold the contents of one evicted page.  A bitmap
+   tracks which slots are in use.
+
+   The frame table evicts pages in clusters of up to
+   SWAP_CLUSTER_PAGES, which are given consecutive slots and
+   handed to a dedicated writer thread, so that each cluster
+   costs a single multi-sector disk request and the evicting
+   thread is free to do other work while it is written.  For
+   each slot we also remember which page was written there.
+   When a page is read back in, the pages in the slots that
+   follow, which were most likely evicted together with it, can
+   then be read ahead by the same request.
+
+   After fork(), parent and child may share a slot, so each slot
+   has a reference count, and it only becomes free when the last
+   page using it lets go.
+
+   Optionally, a compressed cache in memory (see vm/zswap.c)
+   takes the pages that the writer thread would otherwise write
+   to disk, and only writes them out once it fills up.  Such a
+   page still has its slot, but the slot only holds its contents
+   once written. */
+
+/* Number of sectors per page-size swap slot. */
+#define SECTORS_PER_SLOT (PGSIZE / BLOCK_SECTOR_SIZE)
+
+/* Swap device, or a null pointer if there is none. */
+static struct block *swap_device;
+
+/* Used swap slots. */
+static struct bitmap *used_slots;
+
+/* A swap slot. */
+struct slot
+  {
+    unsigned ref_cnt;           /* Number of pages using the slot. */
+    struct thread *thread;      /* Owning thread, if known. */
+    void *upage;                /* Owner's user virtual address. */
+  };
+
+/* All the swap slots. */
+static struct slot *slots;
+
+/* Protects used_slots and slots. */
+static struct lock swap_lock;
+
+/* Requests waiting for the swap writer, in submission order. */
+static struct list swap_queue;
+static struct lock swap_queue_lock;
+static struct semaphore swap_queue_sema;
+
+static void read_slots (size_t slot, void *const kpages[], size_t page_cnt);
+static void write_slots (size_t slot, const void *const kpages[],
+                         size_t page_cnt);
+static void write_slot (size_t slot, const void *kpage);
+static thread_func swap_writer NO_RETURN;
+
+/* Sets up swap space on the block device in the swap role, if
+   there is one, and starts the swap writer thread.  Without a
+   swap device, swap_alloc() always fails.  If ZSWAP_PAGES is
+   nonzero, also sets up a compressed cache of that many kernel
+   pages in front of the swap device. */
+void
+swap_init (size_t zswap_pages)
+{
+  size_t slot_cnt = 0;
+
+  swap_device = block_get_role (BLOCK_SWAP);
+  if (swap_device != NULL)
+    slot_cnt = block_size (swap_device) / SECTORS_PER_SLOT;
+  else
+    printf ("swap: no swap device, swapping disabled\n");
+
+  used_slots = bitmap_create (slot_cnt);
+  if (used_slots == NULL)
+    PANIC ("swap: bitmap creation failed");
+  lock_init (&swap_lock);
+
+  list_init (&swap_queue);
+  lock_init (&swap_queue_lock);
+  sema_init (&swap_queue_sema, 0);
+
+  if (slot_cnt > 0)
+    {
+      slots = calloc (slot_cnt, sizeof *slots);
+      if (slots == NULL)
+        PANIC ("swap: slot table allocation failed");
+      zswap_init (zswap_pages, write_slot);
+      thread_create ("swapd", PRI_DEFAULT, swap_writer, NULL);
+    }
+}
+
+/* Allocates up to *PAGE_CNT consecutive swap slots, preferring
+   as many as possible, and stores the number actually allocated
+   in *PAGE_CNT.  Each slot starts out with one reference.
+   Returns the index of the first slot, or SWAP_ERROR if swap
+   space is full. */
+size_t
+swap_alloc (size_t *page_cnt)
+{
+  size_t slot = BITMAP_ERROR;
+  size_t cnt, i;
+
+  ASSERT (*page_cnt > 0);
+
+  lock_acquire (&swap_lock);
+  for (cnt = *page_cnt; cnt > 0; cnt--)
+    {
+      slot = bitmap_scan_and_flip (used_slots, 0, cnt, false);
+      if (slot != BITMAP_ERROR)
+        break;
+    }
+  if (slot != BITMAP_ERROR)
+    for (i = 0; i < cnt; i++)
+      slots[slot + i].ref_cnt = 1;
+  lock_release (&swap_lock);
+
+  if (slot == BITMAP_ERROR)
+    return SWAP_ERROR;
+  *page_cnt = cnt;
+  return slot;
+}
+
+/* Queues request R for the swap writer thread and returns
+   immediately.  R->done is called from the writer thread once
+   all of R's pages have reached the disk, and must not be
+   freed or reused before then. */
+void
+swap_write (struct swap_request *r)
+{
+  ASSERT (r->page_cnt > 0 && r->page_cnt <= SWAP_CLUSTER_PAGES);
+  ASSERT (r->done != NULL);
+
+  lock_acquire (&swap_queue_lock);
+  list_push_back (&swap_queue, &r->elem);
+  lock_release (&swap_queue_lock);
+  sema_up (&swap_queue_sema);
+}
+
+/* Reads the PAGE_CNT pages in the consecutive swap slots
+   starting at SLOT into KPAGES, and drops a reference to each
+   slot.  Pages in the compressed cache are decompressed, and the
+   rest are read from disk, using a single disk request for each
+   run of consecutive slots. */
+void
+swap_read (size_t slot, void *const kpages[], size_t page_cnt)
+{
+  size_t start, i;
+
+  ASSERT (page_cnt > 0 && page_cnt <= SWAP_CLUSTER_PAGES);
+
+  for (start = i = 0; i < page_cnt; i++)
+    if (zswap_load (slot + i, kpages[i]))
+      {
+        if (start < i)
+          read_slots (slot + start, kpages + start, i - start);
+        start = i + 1;
+      }
+  if (start < page_cnt)
+    read_slots (slot + start, kpages + start, page_cnt - start);
+
+  for (i = 0; i < page_cnt; i++)
+    swap_free (slot + i);
+}
+
+/* Drops a reference to swap slot SLOT without reading it,
+   freeing the slot if that was the last one. */
+void
+swap_free (size_t slot)
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (used_slots, slot));
+  ASSERT (slots[slot].ref_cnt > 0);
+  if (--slots[slot].ref_cnt == 0)
+    {
+      zswap_invalidate (slot);
+      bitmap_reset (used_slots, slot);
+      slots[slot].thread = NULL;
+      slots[slot].upage = NULL;
+    }
+  lock_release (&swap_lock);
+}
+
+/* Adds a reference to used swap slot SLOT, for a page that
+   shares it with the pages already using it. */
+void
+swap_dup (size_t slot)
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (used_slots, slot));
+  slots[slot].ref_cnt++;
+  lock_release (&swap_lock);
+}
+
+/* Records that used swap slot SLOT holds the page at UPAGE in
+   thread T's address space. */
+void
+swap_set_owner (size_t slot, struct thread *t, void *upage)
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (used_slots, slot));
+  slots[slot].thread = t;
+  slots[slot].upage = upage;
+  lock_release (&swap_lock);
+}
+
+/* If SLOT is a used swap slot that holds a page belonging to
+   thread T, returns the page's user virtual address.  Otherwise,
+   returns a null pointer. */
+void *
+swap_owner (size_t slot, struct thread *t)
+{
+  void *upage = NULL;
+
+  if (slot >= bitmap_size (used_slots))
+    return NULL;
+
+  lock_acquire (&swap_lock);
+  if (bitmap_test (used_slots, slot) && slots[slot].thread == t)
+    upage = slots[slot].upage;
+  lock_release (&swap_lock);
+
+  return upage;
+}
+
+/* Reads the PAGE_CNT pages in the consecutive swap slots
+   starting at SLOT from disk into KPAGES, using a single disk
+   request. */
+static void
+read_slots (size_t slot, void *const kpages[], size_t page_cnt)
+{
+  void *sectors[SWAP_CLUSTER_PAGES * SECTORS_PER_SLOT];
+  size_t i;
+
+  for (i = 0; i < page_cnt * SECTORS_PER_SLOT; i++)
+    sectors[i] = (uint8_t *) kpages[i / SECTORS_PER_SLOT]
+                 + i % SECTORS_PER_SLOT * BLOCK_SECTOR_SIZE;
+  block_read_multiple (swap_device, slot * SECTORS_PER_SLOT, sectors,
+                       page_cnt * SECTORS_PER_SLOT);
+}
+
+/* Writes the PAGE_CNT pages in KPAGES to disk in the consecutive
+   swap slots starting at SLOT, using a single disk request. */
+static void
+write_slots (size_t slot, const void *const kpages[], size_t page_cnt)
+{
+  const void *sectors[SWAP_CLUSTER_PAGES * SECTORS_PER_SLOT];
+  size_t i;
+
+  for (i = 0; i < page_cnt * SECTORS_PER_SLOT; i++)
+    sectors[i] = (const uint8_t *) kpages[i / SECTORS_PER_SLOT]
+                 + i % SECTORS_PER_SLOT * BLOCK_SECTOR_SIZE;
+  block_write_multiple (swap_device, slot * SECTORS_PER_SLOT, sectors,
+                        page_cnt * SECTORS_PER_SLOT);
+}
+
+/* Writes KPAGE to disk in swap slot SLOT.  Used by the
+   compressed cache when it fills up. */
+static void
+write_slot (size_t slot, const void *kpage)
+{
+  write_slots (slot, &kpage, 1);
+}
+
+/* Swap writer thread.  Stores each queued request's pages in the
+   compressed cache, if possible, and writes the rest to disk,
+   using a single disk request for each run of consecutive
+   slots.  Handles requests in order, notifying each submitter
+   once done. */
+static void
+swap_writer (void *aux UNUSED)
+{
+  for (;;)
+    {
+      struct swap_request *r;
+      size_t start, i;
+
+      sema_down (&swap_queue_sema);
+      lock_acquire (&swap_queue_lock);
+      r = list_entry (list_pop_front (&swap_queue),
+                      struct swap_request, elem);
+      lock_release (&swap_queue_lock);
+
+      for (start = i = 0; i < r->page_cnt; i++)
+        if (zswap_store (r->slot + i, r->kpages[i]))
+          {
+            if (start < i)
+              write_slots (r->slot + start, r->kpages + start, i - start);
+            start = i + 1;
+          }
+      if (start < r->page_cnt)
+        write_slots (r->slot + start, r->kpages + start,
+                     r->page_cnt - start);
+      r->done (r);
+    }
+}
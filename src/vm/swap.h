@@ -0,0 +1,37 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
+#include <list.h>
+#include <stddef.h>
+
+struct thread;
+
+/* Returned by swap_alloc() when no swap slot is free. */
+#define SWAP_ERROR SIZE_MAX
+
+/* Maximum number of pages written to swap in one request. */
+#define SWAP_CLUSTER_PAGES 8
+
+/* A request to write a cluster of pages to consecutive swap
+   slots, carried out in the background by the swap writer
+   thread. */
+struct swap_request
+  {
+    size_t slot;                /* First slot, from swap_alloc(). */
+    size_t page_cnt;            /* Number of pages. */
+    const void *kpages[SWAP_CLUSTER_PAGES]; /* Pages to write. */
+    void (*done) (struct swap_request *); /* Called once written. */
+    void *aux;                  /* For use by DONE. */
+    struct list_elem elem;      /* Element in swap writer's queue. */
+  };
+
+void swap_init (size_t zswap_pages);
+size_t swap_alloc (size_t *page_cnt);
+void swap_write (struct swap_request *);
+void swap_read (size_t slot, void *const kpages[], size_t page_cnt);
+void swap_free (size_t slot);
+void swap_dup (size_t slot);
+void swap_set_owner (size_t slot, struct thread *, void *upage);
+void *swap_owner (size_t slot, struct thread *);
+
+#endif /* vm/swap.h */
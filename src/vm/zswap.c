@@ -0,0 +1,306 @@
+#include "vm/zswap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <lz4.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Compressed swap cache.
+
+   Sits in front of the swap device.  Pages on their way to swap
+   are compressed and kept in a pool of kernel pages instead of
+   being written out, as long as they compress well enough and
+   there is room.  Each one still has its swap slot, which also
+   identifies it here, so the swap slot allocator and reference
+   counts work the same either way.
+
+   When the pool is full, the oldest compressed pages are
+   decompressed and written to their slots on the swap device to
+   make room for new ones.  A page stays readable here until it
+   is on disk.
+
+   Only the swap writer thread stores pages, so it alone uses the
+   compression buffers below. */
+
+/* The pool is allocated in chunks of this many bytes. */
+#define CHUNK_SIZE 64
+
+/* Pages that don't compress at least this well go to disk. */
+#define MAX_COMPRESSED (PGSIZE * 3 / 4)
+
+/* A compressed page. */
+struct zentry
+  {
+    size_t slot;                /* Swap slot. */
+    size_t chunk;               /* First chunk in pool. */
+    size_t size;                /* Compressed size in bytes. */
+    bool writeback;             /* Being written to its slot? */
+    struct hash_elem hash_elem; /* Element in `entries'. */
+    struct list_elem lru_elem;  /* Element in `lru', unless WRITEBACK. */
+  };
+
+/* Pool of compressed pages, or a null pointer if disabled. */
+static uint8_t *pool;
+static struct bitmap *used_chunks;
+
+/* Compressed pages, by slot and from oldest to newest. */
+static struct hash entries;
+static struct list lru;
+
+/* Protects all of the above and the statistics. */
+static struct lock zswap_lock;
+
+/* Writes a page to its slot on the swap device. */
+static void (*write_back_func) (size_t slot, const void *kpage);
+
+/* Scratch space for the swap writer thread. */
+static uint8_t compress_buf[MAX_COMPRESSED];
+static uint16_t lz4_table[LZ4_TABLE_SIZE];
+static void *bounce_page;
+
+/* Statistics. */
+static unsigned long long store_cnt;    /* Pages compressed. */
+static unsigned long long store_bytes;  /* Their compressed size. */
+static unsigned long long reject_cnt;   /* Pages sent to disk instead. */
+static unsigned long long writeback_cnt; /* Pages moved to disk. */
+static unsigned long long hit_cnt;      /* Swap-ins from the pool. */
+static unsigned long long miss_cnt;     /* Swap-ins from disk. */
+
+static hash_hash_func zentry_hash;
+static hash_less_func zentry_less;
+static struct zentry *find_entry (size_t slot);
+static void remove_entry (struct zentry *);
+static bool write_back_oldest (void);
+
+/* Sets up a compressed swap cache of PAGE_CNT kernel pages, which
+   calls WRITE_BACK to write pages to disk when it fills up.  Does
+   nothing if PAGE_CNT is 0. */
+void
+zswap_init (size_t page_cnt,
+            void (*write_back) (size_t slot, const void *kpage))
+{
+  if (page_cnt == 0)
+    return;
+
+  lock_init (&zswap_lock);
+  list_init (&lru);
+  write_back_func = write_back;
+  pool = palloc_get_multiple (0, page_cnt);
+  bounce_page = palloc_get_page (0);
+  used_chunks = bitmap_create (page_cnt * PGSIZE / CHUNK_SIZE);
+  if (pool == NULL || bounce_page == NULL || used_chunks == NULL
+      || !hash_init (&entries, zentry_hash, zentry_less, NULL))
+    PANIC ("zswap: not enough memory for %zu-page pool", page_cnt);
+
+  printf ("zswap: %zu-page compressed swap cache\n", page_cnt);
+}
+
+/* Compresses KPAGE, the contents of the page headed for swap slot
+   SLOT, into the cache, writing older pages to disk if
+   necessary to make room.  Returns true if successful, false if
+   the cache is disabled or KPAGE doesn't compress well, in which
+   case the caller must write it to disk itself.
+   Must be called only from the swap writer thread. */
+bool
+zswap_store (size_t slot, const void *kpage)
+{
+  struct zentry *e;
+  size_t size, chunk_cnt, chunk;
+
+  if (pool == NULL)
+    return false;
+
+  size = lz4_compress (kpage, PGSIZE, compress_buf, sizeof compress_buf,
+                       lz4_table);
+  e = size > 0 ? malloc (sizeof *e) : NULL;
+
+  lock_acquire (&zswap_lock);
+  ASSERT (find_entry (slot) == NULL);
+  if (e == NULL)
+    {
+      reject_cnt++;
+      lock_release (&zswap_lock);
+      return false;
+    }
+
+  chunk_cnt = DIV_ROUND_UP (size, CHUNK_SIZE);
+  while ((chunk = bitmap_scan_and_flip (used_chunks, 0, chunk_cnt, false))
+         == BITMAP_ERROR)
+    if (!write_back_oldest ())
+      {
+        reject_cnt++;
+        lock_release (&zswap_lock);
+        free (e);
+        return false;
+      }
+
+  memcpy (pool + chunk * CHUNK_SIZE, compress_buf, size);
+  e->slot = slot;
+  e->chunk = chunk;
+  e->size = size;
+  e->writeback = false;
+  hash_insert (&entries, &e->hash_elem);
+  list_push_back (&lru, &e->lru_elem);
+  store_cnt++;
+  store_bytes += size;
+  lock_release (&zswap_lock);
+
+  return true;
+}
+
+/* If swap slot SLOT's page is in the cache, decompresses it into
+   KPAGE and returns true.  Otherwise, returns false, and the
+   caller must read it from disk.  The page stays in the cache
+   either way, in case another process shares the slot. */
+bool
+zswap_load (size_t slot, void *kpage)
+{
+  struct zentry *e;
+
+  if (pool == NULL)
+    return false;
+
+  lock_acquire (&zswap_lock);
+  e = find_entry (slot);
+  if (e != NULL)
+    {
+      if (!lz4_decompress (pool + e->chunk * CHUNK_SIZE, e->size,
+                           kpage, PGSIZE))
+        PANIC ("zswap: slot %zu is corrupt", slot);
+      hit_cnt++;
+    }
+  else
+    miss_cnt++;
+  lock_release (&zswap_lock);
+
+  return e != NULL;
+}
+
+/* Drops swap slot SLOT's page from the cache, if it is there,
+   because the slot is being freed. */
+void
+zswap_invalidate (size_t slot)
+{
+  struct zentry *e;
+
+  if (pool == NULL)
+    return;
+
+  lock_acquire (&zswap_lock);
+  e = find_entry (slot);
+  if (e != NULL)
+    remove_entry (e);
+  lock_release (&zswap_lock);
+}
+
+/* Prints compressed swap cache statistics. */
+void
+zswap_print_stats (void)
+{
+  unsigned long long ratio, hit_rate;
+
+  if (pool == NULL)
+    return;
+
+  ratio = store_bytes > 0 ? store_cnt * PGSIZE * 100 / store_bytes : 0;
+  hit_rate = hit_cnt + miss_cnt > 0 ? hit_cnt * 100 / (hit_cnt + miss_cnt) : 0;
+  printf ("zswap: %llu pages compressed, %llu rejected, "
+          "%llu written back\n",
+          store_cnt, reject_cnt, writeback_cnt);
+  printf ("zswap: compression ratio %llu.%02llu, "
+          "%llu hits, %llu misses (%llu%% hit rate)\n",
+          ratio / 100, ratio % 100, hit_cnt, miss_cnt, hit_rate);
+}
+
+/* Returns a hash value for the entry that E refers to. */
+static unsigned
+zentry_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  return hash_int (hash_entry (e, struct zentry, hash_elem)->slot);
+}
+
+/* Returns true if entry A precedes entry B. */
+static bool
+zentry_less (const struct hash_elem *a, const struct hash_elem *b,
+             void *aux UNUSED)
+{
+  return (hash_entry (a, struct zentry, hash_elem)->slot
+          < hash_entry (b, struct zentry, hash_elem)->slot);
+}
+
+/* Returns the entry for swap slot SLOT, or a null pointer if
+   there is none.
+   Must be called with zswap_lock held. */
+static struct zentry *
+find_entry (size_t slot)
+{
+  struct zentry key;
+  struct hash_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&zswap_lock));
+
+  key.slot = slot;
+  e = hash_find (&entries, &key.hash_elem);
+  return e != NULL ? hash_entry (e, struct zentry, hash_elem) : NULL;
+}
+
+/* Removes entry E from the cache and frees it.
+   Must be called with zswap_lock held. */
+static void
+remove_entry (struct zentry *e)
+{
+  ASSERT (lock_held_by_current_thread (&zswap_lock));
+
+  hash_delete (&entries, &e->hash_elem);
+  if (!e->writeback)
+    list_remove (&e->lru_elem);
+  bitmap_set_multiple (used_chunks, e->chunk,
+                       DIV_ROUND_UP (e->size, CHUNK_SIZE), false);
+  free (e);
+}
+
+/* Writes the oldest page in the cache to its swap slot, then
+   removes it from the cache.  zswap_lock is released while the
+   page is written, but until then, the page can still be loaded
+   from the cache.  Returns false if the cache is empty.
+   Must be called with zswap_lock held, from the swap writer
+   thread. */
+static bool
+write_back_oldest (void)
+{
+  struct zentry *e;
+  size_t slot;
+
+  ASSERT (lock_held_by_current_thread (&zswap_lock));
+
+  if (list_empty (&lru))
+    return false;
+
+  e = list_entry (list_pop_front (&lru), struct zentry, lru_elem);
+  e->writeback = true;
+  slot = e->slot;
+  if (!lz4_decompress (pool + e->chunk * CHUNK_SIZE, e->size,
+                       bounce_page, PGSIZE))
+    PANIC ("zswap: slot %zu is corrupt", slot);
+
+  lock_release (&zswap_lock);
+  write_back_func (slot, bounce_page);
+  lock_acquire (&zswap_lock);
+
+  /* The slot may have been freed while we wrote it.  Only we can
+     store a page in it again, so if there is an entry, it is
+     still E. */
+  e = find_entry (slot);
+  if (e != NULL)
+    remove_entry (e);
+  writeback_cnt++;
+  return true;
+}